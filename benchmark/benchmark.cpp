@@ -7,20 +7,20 @@
 #include <numeric>
 #include <sstream>
 #include <string>
+#include <unordered_set>
 
 #include "json.hpp"
 
-template <typename parser>
-void do_benchmark(const std::string& content, const std::string& tag)
+template <typename func_t>
+void do_benchmark(const std::string& tag, size_t bytes, func_t&& func)
 {
     std::vector<double> iteration_time_ms;
     iteration_time_ms.reserve(10000);
     auto start = std::chrono::steady_clock::now();
-    bool parsed = false;
+    bool ret = false;
     while (true) {
         auto t0 = std::chrono::steady_clock::now();
-        auto opt = parser::parse(content);
-        parsed = opt.has_value();
+        ret = func();
 
         auto t1 = std::chrono::steady_clock::now();
         iteration_time_ms.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
@@ -52,8 +52,263 @@ void do_benchmark(const std::string& content, const std::string& tag)
         median = iteration_time_ms[loop_times / 2];
     }
 
-    std::cout << tag << ", " << std::boolalpha << parsed << ", " << loop_times << ", " << mean
-              << ", " << median << ", " << stdev << std::endl;
+    double throughput = median > 0 ? bytes / (median / 1000) / (1024 * 1024) : 0;
+
+    std::cout << tag << ", " << std::boolalpha << ret << ", " << loop_times << ", " << mean
+              << ", " << median << ", " << stdev << ", " << throughput << std::endl;
+}
+
+template <typename parser>
+void do_parse_benchmark(const std::string& content, const std::string& tag)
+{
+    do_benchmark(tag, content.size(), [&]() { return parser::parse(content).has_value(); });
+}
+
+void do_serializing_benchmark(const std::string& content, const std::string& filename)
+{
+    auto opt = json::parse(content);
+    if (!opt) {
+        return;
+    }
+    const json::value& val = *opt;
+
+    do_benchmark(filename + ", dump", val.to_string().size(), [&]() { return !val.to_string().empty(); });
+    json::serializer reused;
+    do_benchmark(filename + ", dump_reused", val.to_string().size(), [&]() { return !reused.dump(val).empty(); });
+    do_benchmark(filename + ", format", val.format().size(), [&]() { return !val.format().empty(); });
+
+    json::format_options tab_compact { 1, '\t', true };
+    do_benchmark(filename + ", format_tab_compact", val.format(tab_compact).size(), [&]() {
+        return !val.format(tab_compact).empty();
+    });
+}
+
+// ownership costs of a parsed document that is never snapshotted: every node is uniquely owned
+void do_ownership_benchmark(const std::string& content, const std::string& filename)
+{
+    auto opt = json::parse(content);
+    if (!opt) {
+        return;
+    }
+    const json::value& val = *opt;
+
+    do_benchmark(filename + ", parse+destroy", content.size(), [&]() { return json::parse(content).has_value(); });
+    do_benchmark(filename + ", copy+destroy", content.size(), [&]() {
+        json::value copied = val;
+        return copied.valid();
+    });
+    do_benchmark(filename + ", snapshot", content.size(), [&]() { return val.snapshot().valid(); });
+}
+
+// heap breakdown of the parsed document, and what it costs to sample it
+void do_memory_usage_benchmark(const std::string& content, const std::string& filename)
+{
+    auto opt = json::parse(content);
+    if (!opt) {
+        return;
+    }
+    const json::value& val = *opt;
+
+    const json::memory_stats stats = val.memory_usage();
+    std::cout << filename << ", memory, total " << stats.total() << ", strings " << stats.strings
+              << ", array_buffers " << stats.array_buffers << " (slack " << stats.array_slack << ")"
+              << ", object_nodes " << stats.object_nodes << ", containers " << stats.containers << ", values "
+              << stats.nulls + stats.booleans + stats.numbers + stats.string_values + stats.arrays + stats.objects
+              << " (" << stats.objects << " objects, " << stats.arrays << " arrays, " << stats.string_values
+              << " strings, " << stats.numbers << " numbers)" << std::endl;
+
+    do_benchmark(filename + ", memory_usage", content.size(), [&]() { return val.memory_usage().total() != 0; });
+}
+
+struct BenchItem
+{
+    std::string name;
+    double price = 0;
+    std::vector<int> tags;
+
+    MEO_JSONIZATION(name, price, tags);
+};
+
+// decoding records that all convert, i.e. the path that must not pay for error reporting
+void do_jsonization_benchmark()
+{
+    std::vector<BenchItem> items(10000);
+    for (size_t i = 0; i < items.size(); ++i) {
+        items[i].name = "item " + std::to_string(i);
+        items[i].price = static_cast<double>(i) / 4;
+        items[i].tags = { static_cast<int>(i), 1, 2 };
+    }
+    const json::value val = items;
+    const size_t bytes = val.to_string().size();
+
+    do_benchmark("records, from_json", bytes, [&]() { return val.as<std::vector<BenchItem>>().size() == items.size(); });
+    do_benchmark("records, try_as", bytes, [&]() { return val.try_as<std::vector<BenchItem>>().has_value(); });
+}
+
+// copy, comparison, dump, destruction and parsing of a deeply nested, a wide and a long flat document
+void do_tree_benchmark()
+{
+    json::value deep;
+    for (int i = 0; i < 10000; ++i) {
+        json::array level;
+        level.emplace_back(std::move(deep));
+        level.emplace_back(i);
+        deep = std::move(level);
+    }
+
+    json::value wide;
+    for (int i = 0; i < 20000; ++i) {
+        wide["item " + std::to_string(i)] = json::object { { "id", i }, { "tags", json::array { i, "x", true } } };
+    }
+
+    json::array flat;
+    for (int i = 0; i < 200000; ++i) {
+        flat.emplace_back(i % 1000);
+    }
+    json::value long_array = std::move(flat);
+
+    for (const auto& [tag, val] :
+         { std::make_pair("deep", &deep), std::make_pair("wide", &wide), std::make_pair("long array", &long_array) }) {
+        const size_t bytes = val->to_string().size();
+        const json::value copied = *val;
+        do_benchmark(std::string(tag) + ", copy+destroy", bytes, [&]() {
+            json::value tmp = *val;
+            return tmp.valid();
+        });
+        do_benchmark(std::string(tag) + ", compare", bytes, [&]() { return *val == copied; });
+        do_benchmark(std::string(tag) + ", dump", bytes, [&]() { return !val->to_string().empty(); });
+        const std::string text = val->to_string();
+        do_benchmark(std::string(tag) + ", parse", bytes, [&]() { return json::parse(text).has_value(); });
+    }
+}
+
+// dedup cache keyed by ~10 KB documents that only differ deep in their last record
+void do_hash_benchmark()
+{
+    auto make_doc = [](int id) {
+        json::value doc;
+        for (int i = 0; i < 300; ++i) {
+            doc["payload"].as_array().emplace_back(json::object { { "index", i }, { "name", "record " + std::to_string(i) } });
+        }
+        doc["payload"][299]["id"] = id;
+        return doc;
+    };
+
+    std::vector<json::value> probes;
+    std::unordered_set<json::value> cache;
+    for (int i = 0; i < 1000; ++i) {
+        probes.emplace_back(make_doc(i * 2));
+        cache.emplace(make_doc(i * 2 + 1));
+    }
+    const json::value lhs = make_doc(0);
+    const json::value rhs = make_doc(1);
+    const size_t bytes = lhs.to_string().size();
+    do_benchmark("10KB documents, compare", bytes, [&]() { return lhs != rhs; });
+    do_benchmark("10KB documents, compare hashed", bytes, [&]() { return lhs.hash() != rhs.hash() && lhs != rhs; });
+    do_benchmark("10KB documents, 1000 cache misses", bytes * probes.size(), [&]() {
+        return std::none_of(probes.cbegin(), probes.cend(), [&](const json::value& probe) { return cache.count(probe); });
+    });
+}
+
+// layered configuration: defaults, then environment, then overrides, each parsed from text
+void do_merge_benchmark()
+{
+    json::value defaults;
+    json::value env;
+    json::value overrides;
+    for (int i = 0; i < 5000; ++i) {
+        const std::string section = "section " + std::to_string(i);
+        defaults[section] = json::object { { "enabled", false }, { "limit", i }, { "tags", json::array { "a", "b" } } };
+        if (i % 2 == 0) {
+            env[section] = json::object { { "limit", i * 2 }, { "comment", std::string(64, 'x') } };
+        }
+        if (i % 10 == 0) {
+            overrides[section] = json::object { { "enabled", true } };
+        }
+    }
+    const std::string defaults_text = defaults.to_string();
+    const std::string env_text = env.to_string();
+    const std::string overrides_text = overrides.to_string();
+    const size_t bytes = defaults_text.size() + env_text.size() + overrides_text.size();
+
+    do_benchmark("layered config, parse only", bytes, [&]() {
+        return json::parse(defaults_text) && json::parse(env_text) && json::parse(overrides_text);
+    });
+    do_benchmark("layered config, merge copies", bytes, [&]() {
+        json::value config = *json::parse(defaults_text);
+        const json::value env_layer = *json::parse(env_text);
+        const json::value overrides_layer = *json::parse(overrides_text);
+        config.merge(env_layer).merge(overrides_layer);
+        return config.is_object();
+    });
+    do_benchmark("layered config, merge moves", bytes, [&]() {
+        json::value config = *json::parse(defaults_text);
+        json::value env_layer = *json::parse(env_text);
+        json::value overrides_layer = *json::parse(overrides_text);
+        config.merge(std::move(env_layer)).merge(std::move(overrides_layer));
+        return config.is_object();
+    });
+}
+
+// key lookups in a large read-only table, tree against frozen buffer
+void do_frozen_benchmark()
+{
+    json::value table;
+    for (int i = 0; i < 50000; ++i) {
+        table["key " + std::to_string(i)] = json::object { { "id", i }, { "name", "item " + std::to_string(i) } };
+    }
+    const std::string text = table.to_string();
+    const json::frozen_value frozen(table);
+
+    std::vector<std::string> keys;
+    for (int i = 0; i < 50000; i += 7) {
+        keys.emplace_back("key " + std::to_string(i * 7919 % 50000));
+    }
+
+    do_benchmark("lookup table, parse", text.size(), [&]() { return json::parse(text).has_value(); });
+    do_benchmark("lookup table, parse_frozen", text.size(), [&]() { return json::parse_frozen(text).has_value(); });
+    do_benchmark("lookup table, value lookups", text.size(), [&]() {
+        long long sum = 0;
+        for (const auto& key : keys) {
+            sum += table.at(key).at("id").as_long_long();
+        }
+        return sum != 0;
+    });
+    do_benchmark("lookup table, frozen lookups", text.size(), [&]() {
+        long long sum = 0;
+        const auto root = frozen.root();
+        for (const auto& key : keys) {
+            sum += root.at(key).at("id").as_long_long();
+        }
+        return sum != 0;
+    });
+}
+
+// versioned configuration store: one small edit per version of a wide document
+void do_persistent_benchmark()
+{
+    json::value table;
+    for (int i = 0; i < 50000; ++i) {
+        table["key " + std::to_string(i)] = json::object { { "id", i }, { "name", "item " + std::to_string(i) } };
+    }
+    const json::persistent_value base(table);
+    const size_t bytes = table.to_string().size();
+
+    do_benchmark("versioned table, from value", bytes, [&]() { return json::persistent_value(table).size() == 50000; });
+    do_benchmark("versioned table, 1000 versions", bytes, [&]() {
+        std::vector<json::persistent_value> versions { base };
+        for (int i = 0; i < 1000; ++i) {
+            versions.emplace_back(versions.back().set("/key " + std::to_string(i * 37 % 50000) + "/id", -i));
+        }
+        return versions.back() != base;
+    });
+    do_benchmark("versioned table, lookups", bytes, [&]() {
+        long long sum = 0;
+        for (int i = 0; i < 50000; i += 7) {
+            sum += base.at("key " + std::to_string(i)).at("id").as_long_long();
+        }
+        return sum != 0;
+    });
 }
 
 int main(int argc, char** argv)
@@ -63,7 +318,14 @@ int main(int argc, char** argv)
         return -1;
     }
 
-    std::cout << "file, parser, ret, sample_count, mean, median, stdev" << std::endl;
+    std::cout << "file, case, ret, sample_count, mean, median, stdev, MB/s" << std::endl;
+
+    do_jsonization_benchmark();
+    do_tree_benchmark();
+    do_hash_benchmark();
+    do_merge_benchmark();
+    do_frozen_benchmark();
+    do_persistent_benchmark();
 
     for (int i = 1; i < argc; ++i) {
         std::filesystem::path path(argv[i]);
@@ -81,26 +343,34 @@ int main(int argc, char** argv)
 
         using namespace json::_packed_bytes;
 
-        do_benchmark<json::parser<false, std::string, packed_bytes_trait_none>>(
+        do_parse_benchmark<json::parser<false, std::string, packed_bytes_trait_none>>(
             content,
             path.filename().string() + ", none");
-        do_benchmark<json::parser<false, std::string, packed_bytes_trait_uint32>>(
+        do_parse_benchmark<json::parser<false, std::string, packed_bytes_trait_uint32>>(
             content,
             path.filename().string() + ", bits32");
-        do_benchmark<json::parser<false, std::string, packed_bytes_trait_uint64>>(
+        do_parse_benchmark<json::parser<false, std::string, packed_bytes_trait_uint64>>(
             content,
             path.filename().string() + ", bits64");
 
         if constexpr (packed_bytes_trait<16>::available) {
-            do_benchmark<json::parser<false, std::string, packed_bytes_trait<16>>>(
+            do_parse_benchmark<json::parser<false, std::string, packed_bytes_trait<16>>>(
                 content,
                 path.filename().string() + ", simd128");
         }
         if constexpr (packed_bytes_trait<32>::available) {
-            do_benchmark<json::parser<false, std::string, packed_bytes_trait<32>>>(
+            do_parse_benchmark<json::parser<false, std::string, packed_bytes_trait<32>>>(
                 content,
                 path.filename().string() + ", simd256");
         }
+
+        do_benchmark(path.filename().string() + ", parse_frozen", content.size(), [&]() {
+            return json::parse_frozen(content).has_value();
+        });
+
+        do_serializing_benchmark(content, path.filename().string());
+        do_ownership_benchmark(content, path.filename().string());
+        do_memory_usage_benchmark(content, path.filename().string());
     }
 
     return 0;
@@ -0,0 +1,50 @@
+// Compile-time benchmark for enum reflection, built by the enum_compile_benchmark target.
+// Without MEOJSON_BENCH_ENUM_VALUES every enum reflects the whole default range;
+// with it, only the enumerators listed by MEOJSON_ENUM_VALUES are reflected.
+
+#include "json.hpp"
+
+#ifdef MEOJSON_BENCH_ENUM_VALUES
+#define MEOJSON_BENCH_LIST(n) \
+    MEOJSON_ENUM_VALUES(Enum##n, Enum##n::A, Enum##n::B, Enum##n::C, Enum##n::D, Enum##n::E, Enum##n::F, Enum##n::G, Enum##n::H);
+#else
+#define MEOJSON_BENCH_LIST(n)
+#endif
+
+#define MEOJSON_BENCH_ENUM(n)                  \
+    enum class Enum##n                         \
+    {                                          \
+        A,                                     \
+        B,                                     \
+        C,                                     \
+        D,                                     \
+        E,                                     \
+        F,                                     \
+        G,                                     \
+        H                                      \
+    };                                         \
+    MEOJSON_BENCH_LIST(n)                      \
+    bool use_##n()                             \
+    {                                          \
+        json::value v = Enum##n::C;            \
+        return v.as<Enum##n>() == Enum##n::C;  \
+    }
+
+#define MEOJSON_BENCH_ENUM_10(n)  \
+    MEOJSON_BENCH_ENUM(n##0)      \
+    MEOJSON_BENCH_ENUM(n##1)      \
+    MEOJSON_BENCH_ENUM(n##2)      \
+    MEOJSON_BENCH_ENUM(n##3)      \
+    MEOJSON_BENCH_ENUM(n##4)      \
+    MEOJSON_BENCH_ENUM(n##5)      \
+    MEOJSON_BENCH_ENUM(n##6)      \
+    MEOJSON_BENCH_ENUM(n##7)      \
+    MEOJSON_BENCH_ENUM(n##8)      \
+    MEOJSON_BENCH_ENUM(n##9)
+
+// 50 enums with 8 enumerators each
+MEOJSON_BENCH_ENUM_10(1)
+MEOJSON_BENCH_ENUM_10(2)
+MEOJSON_BENCH_ENUM_10(3)
+MEOJSON_BENCH_ENUM_10(4)
+MEOJSON_BENCH_ENUM_10(5)
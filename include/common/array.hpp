@@ -11,6 +11,7 @@
 #include <vector>
 
 #include "exception.hpp"
+#include "segment_buffer.hpp"
 #include "utils.hpp"
 
 namespace json
@@ -19,6 +20,9 @@ class array
 {
     friend class value;
     friend class object;
+    // fills _array_data straight from its scratch stack
+    template <bool accept_jsonc, typename parsing_t, typename accel_traits>
+    friend class parser;
 
 public:
     using raw_array = std::vector<value>;
@@ -142,11 +146,24 @@ public:
 
     const value& at(size_t pos) const;
 
-    std::string dumps(std::optional<size_t> indent = std::nullopt) const;
+    std::string dumps(std::optional<size_t> indent = std::nullopt, bool ensure_ascii = false) const;
 
     std::string to_string() const;
+    // Appends the compact form to out, reusing its capacity; see also json::serializer
+    void dump_to(std::string& out, bool ensure_ascii = false) const;
 
     std::string format(size_t indent = 4) const;
+    std::string format(const format_options& options) const;
+
+    // RFC 8785 JSON Canonicalization Scheme, for hashing and signing
+    std::string dumps_canonical() const;
+    void dump_canonical_to(std::string& out) const;
+    // sink is called with std::string_view chunks, e.g. a hash update, so the output is never materialized
+    template <typename sink_t, std::enable_if_t<std::is_invocable_v<sink_t&, std::string_view>, bool> = true>
+    void dump_canonical_to(sink_t&& sink) const;
+
+    // Appends the compact form as segments referencing this value's string storage, see segment_buffer
+    void dump_segments_to(segment_buffer& out) const;
 
     template <typename value_t>
     bool all() const;
@@ -171,8 +188,12 @@ private:
     template <typename tuple_t, size_t... Is>
     void move_as_tuple_helper(tuple_t& result, std::index_sequence<Is...>);
 
-    void dump_to(std::string& out) const;
-    void format_to(std::string& out, size_t indent, size_t indent_times) const;
+    template <bool ensure_ascii = false, typename writer_t>
+    void write_compact(writer_t& out) const;
+    void format_to(std::string& out, _utils::indent_cache& indent, size_t indent_times) const;
+    size_t format_size(const format_options& options, size_t indent_times) const;
+    template <typename writer_t>
+    void write_canonical(writer_t& out) const;
 
 public:
 
@@ -296,9 +317,8 @@ private:
     template <typename value_t>
     auto get_helper(const value_t& default_value, size_t pos) const;
 
-    std::string format(size_t indent, size_t indent_times) const;
-
 private:
     raw_array _array_data;
+    _utils::hash_cache _hash;
 };
 } // namespace json
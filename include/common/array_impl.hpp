@@ -17,6 +17,16 @@ inline void append_array_move(array::raw_array& dst, array& src)
     dst.reserve(dst.size() + src.size());
     dst.insert(dst.end(), std::make_move_iterator(src.begin()), std::make_move_iterator(src.end()));
 }
+
+inline bool only_scalars(const array::raw_array& arr) noexcept
+{
+    for (const auto& val : arr) {
+        if (val.is_array() || val.is_object()) {
+            return false;
+        }
+    }
+    return true;
+}
 } // namespace _array_impl_detail
 
 inline array::array() = default;
@@ -154,6 +164,7 @@ inline bool array::exists(size_t pos) const
 
 inline void array::clear() noexcept
 {
+    _hash.reset();
     _array_data.clear();
 }
 
@@ -167,6 +178,7 @@ inline bool array::erase(size_t pos)
 
 inline bool array::erase(iterator iter)
 {
+    _hash.reset();
     if (iter == _array_data.end()) {
         return false;
     }
@@ -177,6 +189,7 @@ inline bool array::erase(iterator iter)
 template <typename... args_t>
 inline decltype(auto) array::emplace_back(args_t&&... args)
 {
+    _hash.reset();
     static_assert(std::is_constructible_v<value_type, args_t...>, "Parameter can't be used to construct a raw_array::value_type");
     return _array_data.emplace_back(std::forward<args_t>(args)...);
 }
@@ -195,53 +208,92 @@ inline const value& array::at(size_t pos) const
 inline std::string array::to_string() const
 {
     std::string str;
-    dump_to(str);
+    write_compact(str);
     return str;
 }
 
-inline void array::dump_to(std::string& out) const
+inline void array::dump_to(std::string& out, bool ensure_ascii) const
 {
-    out.push_back('[');
-    for (auto iter = _array_data.cbegin(); iter != _array_data.cend();) {
-        iter->dump_to(out);
-        if (++iter != _array_data.cend()) {
-            out.push_back(',');
-        }
+    if (ensure_ascii) {
+        write_compact<true>(out);
+    }
+    else {
+        write_compact(out);
+    }
+}
+
+template <bool ensure_ascii, typename writer_t>
+inline void array::write_compact(writer_t& out) const
+{
+    value::write_compact_tree<ensure_ascii>(out, this, nullptr);
+}
+
+inline void array::format_to(std::string& out, _utils::indent_cache& indent, size_t indent_times) const
+{
+    value::format_tree(out, indent, this, nullptr, indent_times);
+}
+
+inline size_t array::format_size(const format_options& options, size_t indent_times) const
+{
+    return value::format_size_tree(options, this, nullptr, indent_times);
+}
+
+inline std::string array::dumps(std::optional<size_t> indent, bool ensure_ascii) const
+{
+    if (indent) {
+        format_options options;
+        options.indent = *indent;
+        options.ensure_ascii = ensure_ascii;
+        return format(options);
     }
-    out.push_back(']');
+    std::string str;
+    dump_to(str, ensure_ascii);
+    return str;
 }
 
-inline std::string array::format(size_t indent, size_t indent_times) const
+inline std::string array::format(size_t indent) const
+{
+    return format(format_options { indent });
+}
+
+inline std::string array::format(const format_options& options) const
 {
     std::string str;
-    format_to(str, indent, indent_times);
+    str.reserve(format_size(options, 0));
+    _utils::indent_cache indent(options);
+    format_to(str, indent, 0);
     return str;
 }
 
-inline void array::format_to(std::string& out, size_t indent, size_t indent_times) const
+inline std::string array::dumps_canonical() const
 {
-    out.push_back('[');
-    out.push_back('\n');
-    for (auto iter = _array_data.cbegin(); iter != _array_data.cend();) {
-        out.append(indent * (indent_times + 1), ' ');
-        iter->format_to(out, indent, indent_times + 1);
-        if (++iter != _array_data.cend()) {
-            out.push_back(',');
-        }
-        out.push_back('\n');
-    }
-    out.append(indent * indent_times, ' ');
-    out.push_back(']');
+    std::string str;
+    dump_canonical_to(str);
+    return str;
 }
 
-inline std::string array::dumps(std::optional<size_t> indent) const
+inline void array::dump_canonical_to(std::string& out) const
 {
-    return indent ? format(*indent) : to_string();
+    write_canonical(out);
 }
 
-inline std::string array::format(size_t indent) const
+template <typename sink_t, std::enable_if_t<std::is_invocable_v<sink_t&, std::string_view>, bool>>
+inline void array::dump_canonical_to(sink_t&& sink) const
+{
+    _utils::callback_writer<std::remove_reference_t<sink_t>> writer(sink);
+    write_canonical(writer);
+    writer.flush();
+}
+
+inline void array::dump_segments_to(segment_buffer& out) const
+{
+    write_compact(out);
+}
+
+template <typename writer_t>
+inline void array::write_canonical(writer_t& out) const
 {
-    return format(indent, 0);
+    value::write_canonical_tree(out, this, nullptr);
 }
 
 template <typename value_t>
@@ -305,11 +357,13 @@ inline const value* array::find_value(size_t pos) const
 
 inline typename array::iterator array::begin() noexcept
 {
+    _hash.reset();
     return _array_data.begin();
 }
 
 inline typename array::iterator array::end() noexcept
 {
+    _hash.reset();
     return _array_data.end();
 }
 
@@ -335,11 +389,13 @@ inline typename array::const_iterator array::cend() const noexcept
 
 inline typename array::reverse_iterator array::rbegin() noexcept
 {
+    _hash.reset();
     return _array_data.rbegin();
 }
 
 inline typename array::reverse_iterator array::rend() noexcept
 {
+    _hash.reset();
     return _array_data.rend();
 }
 
@@ -365,6 +421,7 @@ inline typename array::const_reverse_iterator array::crend() const noexcept
 
 inline value& array::operator[](size_t pos)
 {
+    _hash.reset();
     return _array_data[pos];
 }
 
@@ -375,14 +432,19 @@ inline const value& array::operator[](size_t pos) const
 
 inline array array::operator+(const array& rhs) const&
 {
-    array temp = *this;
+    // sized once for both operands
+    array temp;
+    temp._array_data.reserve(size() + rhs.size());
+    _array_impl_detail::append_array(temp._array_data, *this);
     _array_impl_detail::append_array(temp._array_data, rhs);
     return temp;
 }
 
 inline array array::operator+(array&& rhs) const&
 {
-    array temp = *this;
+    array temp;
+    temp._array_data.reserve(size() + rhs.size());
+    _array_impl_detail::append_array(temp._array_data, *this);
     _array_impl_detail::append_array_move(temp._array_data, rhs);
     return temp;
 }
@@ -401,12 +463,14 @@ inline array array::operator+(array&& rhs) &&
 
 inline array& array::operator+=(const array& rhs)
 {
+    _hash.reset();
     _array_impl_detail::append_array(_array_data, rhs);
     return *this;
 }
 
 inline array& array::operator+=(array&& rhs)
 {
+    _hash.reset();
     _array_impl_detail::append_array_move(_array_data, rhs);
     return *this;
 }
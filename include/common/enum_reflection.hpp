@@ -1,6 +1,8 @@
 #pragma once
 
 #include <array>
+#include <iterator>
+#include <limits>
 #include <optional>
 #include <string_view>
 #include <type_traits>
@@ -15,6 +17,15 @@
 
 #define MEOJSON_ENUM_RANGE(min_enum, max_enum) _MEOJSON_ENUM_MIN = min_enum, _MEOJSON_ENUM_MAX = max_enum
 
+// Lists the enumerators explicitly, so only their names are reflected instead of every value in the range.
+// Use at global namespace scope with qualified enumerators: MEOJSON_ENUM_VALUES(Color, Color::Red, Color::Blue)
+#define MEOJSON_ENUM_VALUES(enum_t, ...)                          \
+    template <>                                                   \
+    struct json::_reflection::enum_values<enum_t>                 \
+    {                                                             \
+        static constexpr enum_t values[] = { __VA_ARGS__ };       \
+    }
+
 namespace json
 {
 namespace _reflection
@@ -128,11 +139,26 @@ template <typename E>
 struct has_enum_max<E, std::void_t<decltype(E::_MEOJSON_ENUM_MAX)>> : std::true_type
 {};
 
+// Specialized by MEOJSON_ENUM_VALUES
+template <typename E>
+struct enum_values;
+
+template <typename E, typename = void>
+struct has_enum_values : std::false_type
+{};
+
+template <typename E>
+struct has_enum_values<E, std::void_t<decltype(enum_values<E>::values)>> : std::true_type
+{};
+
 // 获取枚举最小值
+// the default range is clamped to the underlying type, e.g. 0..128 for uint8_t
 template <typename E, bool = has_enum_min<E>::value>
 struct get_enum_min
 {
-    static constexpr int value = MEOJSON_ENUM_REFLECTION_MIN_ENUMS;
+    static constexpr long long lowest = static_cast<long long>(std::numeric_limits<std::underlying_type_t<E>>::min());
+    static constexpr int value =
+        lowest > MEOJSON_ENUM_REFLECTION_MIN_ENUMS ? static_cast<int>(lowest) : MEOJSON_ENUM_REFLECTION_MIN_ENUMS;
 };
 
 template <typename E>
@@ -145,7 +171,11 @@ struct get_enum_min<E, true>
 template <typename E, bool = has_enum_max<E>::value>
 struct get_enum_max
 {
-    static constexpr int value = MEOJSON_ENUM_REFLECTION_MAX_ENUMS;
+    static constexpr unsigned long long highest =
+        static_cast<unsigned long long>(std::numeric_limits<std::underlying_type_t<E>>::max());
+    static constexpr int value = highest < static_cast<unsigned long long>(MEOJSON_ENUM_REFLECTION_MAX_ENUMS)
+                                     ? static_cast<int>(highest)
+                                     : MEOJSON_ENUM_REFLECTION_MAX_ENUMS;
 };
 
 template <typename E>
@@ -180,19 +210,106 @@ struct enum_name_storage
 };
 
 template <typename E>
-constexpr std::string_view enum_to_string(E val)
+struct enum_entry
 {
-    constexpr int min = enum_range<E>::min;
-    constexpr int max = enum_range<E>::max;
-    constexpr int range = max - min + 1;
+    std::string_view name;
+    E value {};
+};
+
+// Names of the MEOJSON_ENUM_VALUES list, sorted by value
+template <typename E, size_t... Is>
+constexpr auto get_listed_entries(std::index_sequence<Is...>)
+{
+    std::array<enum_entry<E>, sizeof...(Is)> entries { { enum_entry<E> { name<E, enum_values<E>::values[Is]>(),
+                                                                          enum_values<E>::values[Is] }... } };
+    for (size_t i = 1; i < entries.size(); ++i) {
+        for (size_t pos = i; pos > 0 && entries[pos - 1].value > entries[pos].value; --pos) {
+            const auto tmp = entries[pos];
+            entries[pos] = entries[pos - 1];
+            entries[pos - 1] = tmp;
+        }
+    }
+    return entries;
+}
+
+template <typename E, bool = has_enum_values<E>::value>
+struct enum_value_storage
+{
+    static constexpr size_t size = std::size(enum_values<E>::values);
+    static constexpr auto entries = get_listed_entries<E>(std::make_index_sequence<size> {});
+};
+
+template <typename E>
+constexpr size_t count_enum_names()
+{
+    size_t count = 0;
+    for (const auto& n : enum_name_storage<E>::names) {
+        count += n.empty() ? 0 : 1;
+    }
+    return count;
+}
 
+// Valid values of the reflected range, in ascending order
+template <typename E, size_t N>
+constexpr std::array<enum_entry<E>, N> get_range_entries()
+{
+    constexpr int min = enum_range<E>::min;
     const auto& names = enum_name_storage<E>::names;
 
-    int idx = static_cast<int>(val) - min;
-    if (idx >= 0 && idx < range) {
-        return names[idx];
+    std::array<enum_entry<E>, N> entries {};
+    size_t count = 0;
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (!names[i].empty()) {
+            entries[count++] = enum_entry<E> { names[i], static_cast<E>(static_cast<int>(i) + min) };
+        }
+    }
+    return entries;
+}
+
+template <typename E>
+struct enum_value_storage<E, false>
+{
+    static constexpr size_t size = count_enum_names<E>();
+    static constexpr auto entries = get_range_entries<E, size>();
+};
+
+template <typename E>
+constexpr std::string_view enum_to_string(E val)
+{
+    if constexpr (has_enum_values<E>::value) {
+        const auto& entries = enum_value_storage<E>::entries;
+        size_t first = 0;
+        size_t count = entries.size();
+        while (count > 0) {
+            const size_t step = count / 2;
+            if (entries[first + step].value < val) {
+                first += step + 1;
+                count -= step + 1;
+            }
+            else {
+                count = step;
+            }
+        }
+        return first < entries.size() && entries[first].value == val ? entries[first].name : std::string_view {};
+    }
+    else {
+        constexpr int min = enum_range<E>::min;
+        constexpr int max = enum_range<E>::max;
+        constexpr int range = max - min + 1;
+
+        const auto& names = enum_name_storage<E>::names;
+
+        int idx = static_cast<int>(val) - min;
+        if (idx >= 0 && idx < range) {
+            return names[idx];
+        }
+        return {};
     }
-    return {};
+}
+
+constexpr char fold_case(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + 32) : c;
 }
 
 constexpr bool iequals(std::string_view a, std::string_view b)
@@ -201,34 +318,91 @@ constexpr bool iequals(std::string_view a, std::string_view b)
         return false;
     }
     for (size_t i = 0; i < a.size(); ++i) {
-        char c1 = a[i];
-        char c2 = b[i];
-        if (c1 >= 'A' && c1 <= 'Z') {
-            c1 += 32;
-        }
-        if (c2 >= 'A' && c2 <= 'Z') {
-            c2 += 32;
-        }
-        if (c1 != c2) {
+        if (fold_case(a[i]) != fold_case(b[i])) {
             return false;
         }
     }
     return true;
 }
 
+// Case-insensitive three-way comparison, consistent with iequals
+constexpr int icompare(std::string_view a, std::string_view b)
+{
+    const size_t len = a.size() < b.size() ? a.size() : b.size();
+    for (size_t i = 0; i < len; ++i) {
+        const char c1 = fold_case(a[i]);
+        const char c2 = fold_case(b[i]);
+        if (c1 != c2) {
+            return c1 < c2 ? -1 : 1;
+        }
+    }
+    return a.size() == b.size() ? 0 : (a.size() < b.size() ? -1 : 1);
+}
+
+// Valid enumerators only, sorted by case-folded name; equal names keep ascending value order
 template <typename E>
-std::optional<E> string_to_enum(std::string_view str)
+constexpr auto get_sorted_entries()
 {
-    constexpr int min = enum_range<E>::min;
-    constexpr int range = enum_name_storage<E>::range;
+    auto entries = enum_value_storage<E>::entries;
+    // insertion sort: stable, and the tables are small
+    for (size_t i = 1; i < entries.size(); ++i) {
+        const auto entry = entries[i];
+        size_t pos = i;
+        for (; pos > 0 && icompare(entries[pos - 1].name, entry.name) > 0; --pos) {
+            entries[pos] = entries[pos - 1];
+        }
+        entries[pos] = entry;
+    }
+    return entries;
+}
 
-    const auto& names = enum_name_storage<E>::names;
+template <typename E>
+struct enum_lookup_storage
+{
+    static constexpr size_t size = enum_value_storage<E>::size;
+    static constexpr auto entries = get_sorted_entries<E>();
+};
 
-    for (int i = 0; i < range; ++i) {
-        if (!names[i].empty()) {
-            if (iequals(names[i], str)) {
-                return static_cast<E>(i + min);
-            }
+// First entry whose name is not less than str, ignoring case
+template <typename E>
+constexpr const enum_entry<E>* enum_lower_bound(std::string_view str)
+{
+    const auto& entries = enum_lookup_storage<E>::entries;
+    size_t first = 0;
+    size_t count = entries.size();
+    while (count > 0) {
+        const size_t step = count / 2;
+        if (icompare(entries[first + step].name, str) < 0) {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else {
+            count = step;
+        }
+    }
+    return entries.data() + first;
+}
+
+// Case-insensitive, as used when converting json values to enums
+template <typename E>
+std::optional<E> string_to_enum(std::string_view str)
+{
+    const auto& entries = enum_lookup_storage<E>::entries;
+    const auto* entry = enum_lower_bound<E>(str);
+    if (entry != entries.data() + entries.size() && iequals(entry->name, str)) {
+        return entry->value;
+    }
+    return std::nullopt;
+}
+
+template <typename E>
+std::optional<E> string_to_enum_exact(std::string_view str)
+{
+    const auto& entries = enum_lookup_storage<E>::entries;
+    for (const auto* entry = enum_lower_bound<E>(str); entry != entries.data() + entries.size() && iequals(entry->name, str);
+         ++entry) {
+        if (entry->name == str) {
+            return entry->value;
         }
     }
     return std::nullopt;
@@ -29,4 +29,12 @@ public:
 protected:
     std::string _what;
 };
-}
\ No newline at end of file
+
+// Where and why a conversion from json failed
+struct conversion_error
+{
+    // JSON pointer to the innermost failing member, e.g. /items/17/price; empty for the value itself
+    std::string path;
+    std::string reason;
+};
+}
@@ -0,0 +1,153 @@
+// IWYU pragma: private, include <meojson/json.hpp>
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "value.hpp"
+
+namespace json
+{
+// Read-only json document in one contiguous buffer, for reference data that is loaded once and
+// looked up many times. Nodes are addressed by 32-bit offsets into the buffer, object members are
+// sorted by key and found by binary search, so the buffer can be copied byte for byte (bytes(),
+// from_bytes()) or mapped from shared memory and used in place (view()) on the same architecture.
+// Built from a json::value or straight from text with json::parse_frozen().
+class frozen_value
+{
+    template <bool accept_jsonc, typename parsing_t, typename accel_traits>
+    friend class parser;
+
+public:
+    // Handle to a node inside the buffer; cheap to copy, valid as long as the buffer is
+    class node
+    {
+        friend class frozen_value;
+
+    public:
+        value::value_type type() const noexcept;
+
+        bool is_null() const noexcept { return type() == value::value_type::null; }
+        bool is_boolean() const noexcept { return type() == value::value_type::boolean; }
+        bool is_number() const noexcept { return type() == value::value_type::number; }
+        bool is_string() const noexcept { return type() == value::value_type::string; }
+        bool is_array() const noexcept { return type() == value::value_type::array; }
+        bool is_object() const noexcept { return type() == value::value_type::object; }
+
+        bool as_boolean() const;
+        int as_integer() const;
+        long long as_long_long() const;
+        unsigned long long as_unsigned_long_long() const;
+        double as_double() const;
+        std::string_view as_string() const;
+        // text of a number as it was written
+        std::string_view as_number_text() const;
+
+        // elements of an array or members of an object, 0 for scalars
+        size_t size() const noexcept;
+
+        node at(size_t pos) const;
+        node at(std::string_view key) const;
+        std::optional<node> find(size_t pos) const;
+        std::optional<node> find(std::string_view key) const;
+        bool contains(std::string_view key) const { return find(key).has_value(); }
+
+        // members of an object in key order, pos < size()
+        std::string_view key_at(size_t pos) const;
+        node value_at(size_t pos) const;
+
+        value to_value() const;
+
+    private:
+        node(const char* base, uint32_t offset) noexcept
+            : _base(base)
+            , _offset(offset)
+        {
+        }
+
+        uint32_t read_u32(uint32_t offset) const noexcept;
+        std::string_view read_text(uint32_t offset) const noexcept;
+        // where the offsets of elements, or key/value offset pairs of members, start
+        uint32_t table() const noexcept { return _offset + 1 + sizeof(uint32_t); }
+        std::string info() const;
+
+        const char* _base = nullptr;
+        uint32_t _offset = 0;
+    };
+
+public:
+    // null document
+    frozen_value();
+    explicit frozen_value(const value& val);
+
+    frozen_value(const frozen_value&) = default;
+    frozen_value(frozen_value&&) noexcept = default;
+    frozen_value& operator=(const frozen_value&) = default;
+    frozen_value& operator=(frozen_value&&) noexcept = default;
+
+    node root() const noexcept { return node(_buffer.data(), root_offset(_buffer.data())); }
+
+    value to_value() const { return root().to_value(); }
+
+    // The whole document; copy it anywhere and load it again with from_bytes() or view()
+    std::string_view bytes() const noexcept { return _buffer; }
+
+    // Only the header is checked, so the bytes must come from bytes() of a trusted source
+    static std::optional<frozen_value> from_bytes(std::string_view bytes);
+    // Like from_bytes() but without copying, e.g. for shared memory; bytes must outlive the node
+    static std::optional<node> view(std::string_view bytes);
+
+private:
+    // Appends nodes after their children, so arrays and objects are written once with their final
+    // size and a document needs no fix-ups; the root comes last.
+    class builder
+    {
+    public:
+        builder();
+
+        uint32_t add_null() const noexcept { return null_offset; }
+        uint32_t add_boolean(bool b) const noexcept { return b ? true_offset : false_offset; }
+        // strings, numbers and keys
+        uint32_t add_text(value::value_type type, std::string_view text);
+
+        // Children of open arrays (offsets) and objects (key, value offset pairs), innermost last
+        std::vector<uint32_t> pending;
+
+        uint32_t close_array(size_t first);
+        // nullopt for a duplicate key
+        std::optional<uint32_t> close_object(size_t first);
+
+        frozen_value finish(uint32_t root);
+
+    private:
+        uint32_t reserve(size_t bytes);
+        // text of a string node written by add_text()
+        std::string_view key(uint32_t offset) const noexcept;
+
+        std::string _buffer;
+        std::vector<std::pair<uint32_t, uint32_t>> _members;
+    };
+
+    // header: magic, total size, root offset; then the shared null, false and true nodes
+    static constexpr std::string_view magic = "MEOF";
+    static constexpr uint32_t header_size = 4 + 2 * sizeof(uint32_t);
+    static constexpr uint32_t null_offset = header_size;
+    static constexpr uint32_t false_offset = null_offset + 1;
+    static constexpr uint32_t true_offset = false_offset + 2;
+
+    explicit frozen_value(std::string buffer) noexcept
+        : _buffer(std::move(buffer))
+    {
+    }
+
+    static uint32_t root_offset(const char* base) noexcept;
+    static bool check_header(std::string_view bytes) noexcept;
+
+    std::string _buffer;
+};
+} // namespace json
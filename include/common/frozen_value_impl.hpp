@@ -0,0 +1,438 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+#include "exception.hpp"
+#include "frozen_value.hpp"
+
+namespace json
+{
+namespace _frozen_value_impl_detail
+{
+template <typename value_t>
+inline value_t parse_integer(std::string_view text, const char* target_type)
+{
+    value_t result {};
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), result);
+    if (ec != std::errc {} || ptr != text.data() + text.size()) {
+        throw exception("Parse error: cannot convert number '" + std::string(text) + "' to " + target_type);
+    }
+    return result;
+}
+} // namespace _frozen_value_impl_detail
+
+// Node layout, all integers in native byte order and read with memcpy, so offsets need no alignment:
+//   null:           tag
+//   boolean:        tag, 0 or 1
+//   string, number: tag, u32 length, text, '\0'
+//   array:          tag, u32 count, count x u32 element offset
+//   object:         tag, u32 count, count x (u32 key offset, u32 value offset), sorted by key;
+//                   keys are string nodes
+
+inline frozen_value::frozen_value()
+    : frozen_value(builder().finish(null_offset))
+{
+}
+
+inline frozen_value::frozen_value(const value& val)
+{
+    // children are written before their parent, so walk the tree in post-order with an explicit stack
+    struct frame
+    {
+        const value* node = nullptr;
+        size_t first = 0;
+        size_t index = 0;
+        object::const_iterator member;
+    };
+
+    builder build;
+    std::vector<frame> stack;
+    uint32_t finished = 0;
+    // false if val is an array or object whose frame has been pushed instead
+    auto visit = [&](const value& node) {
+        switch (node._type) {
+        case value::value_type::boolean:
+            finished = build.add_boolean(node.as_boolean());
+            return true;
+        case value::value_type::number:
+        case value::value_type::string:
+            finished = build.add_text(node._type, node.as_basic_type_str());
+            return true;
+        case value::value_type::array:
+        case value::value_type::object: {
+            frame& top = stack.emplace_back();
+            top.node = &node;
+            top.first = build.pending.size();
+            if (node.is_object()) {
+                top.member = node.as_object().begin();
+            }
+            return false;
+        }
+        default:
+            finished = build.add_null();
+            return true;
+        }
+    };
+
+    if (!visit(val)) {
+        while (!stack.empty()) {
+            frame& top = stack.back();
+            if (top.node->is_array()) {
+                const array& arr = top.node->as_array();
+                if (top.index < arr.size()) {
+                    if (visit(arr[top.index++])) {
+                        build.pending.emplace_back(finished);
+                    }
+                    continue;
+                }
+                finished = build.close_array(top.first);
+            }
+            else {
+                const object& obj = top.node->as_object();
+                if (top.member != obj.end()) {
+                    const auto& [key, child] = *top.member++;
+                    build.pending.emplace_back(build.add_text(value::value_type::string, key));
+                    if (visit(child)) {
+                        build.pending.emplace_back(finished);
+                    }
+                    continue;
+                }
+                // keys of a std::map are already unique
+                finished = *build.close_object(top.first);
+            }
+            stack.pop_back();
+            if (!stack.empty()) {
+                build.pending.emplace_back(finished);
+            }
+        }
+    }
+    *this = build.finish(finished);
+}
+
+inline std::optional<frozen_value> frozen_value::from_bytes(std::string_view bytes)
+{
+    if (!check_header(bytes)) {
+        return std::nullopt;
+    }
+    return frozen_value(std::string(bytes));
+}
+
+inline std::optional<frozen_value::node> frozen_value::view(std::string_view bytes)
+{
+    if (!check_header(bytes)) {
+        return std::nullopt;
+    }
+    return node(bytes.data(), root_offset(bytes.data()));
+}
+
+inline uint32_t frozen_value::root_offset(const char* base) noexcept
+{
+    uint32_t offset = 0;
+    std::memcpy(&offset, base + magic.size() + sizeof(uint32_t), sizeof(offset));
+    return offset;
+}
+
+inline bool frozen_value::check_header(std::string_view bytes) noexcept
+{
+    if (bytes.size() < true_offset + 2 || bytes.substr(0, magic.size()) != magic) {
+        return false;
+    }
+    uint32_t size = 0;
+    std::memcpy(&size, bytes.data() + magic.size(), sizeof(size));
+    return size == bytes.size() && root_offset(bytes.data()) < size;
+}
+
+// *************************
+// *      builder impl     *
+// *************************
+
+inline frozen_value::builder::builder()
+{
+    _buffer.append(magic);
+    _buffer.append(2 * sizeof(uint32_t), '\0');
+    _buffer.push_back(static_cast<char>(value::value_type::null));
+    _buffer.push_back(static_cast<char>(value::value_type::boolean));
+    _buffer.push_back(0);
+    _buffer.push_back(static_cast<char>(value::value_type::boolean));
+    _buffer.push_back(1);
+}
+
+inline uint32_t frozen_value::builder::reserve(size_t bytes)
+{
+    const size_t offset = _buffer.size();
+    if (bytes > UINT32_MAX - offset) {
+        throw exception("Frozen value error: document exceeds 4 GiB");
+    }
+    _buffer.resize(offset + bytes);
+    return static_cast<uint32_t>(offset);
+}
+
+inline uint32_t frozen_value::builder::add_text(value::value_type type, std::string_view text)
+{
+    if (text.size() > UINT32_MAX) {
+        throw exception("Frozen value error: string exceeds 4 GiB");
+    }
+    const uint32_t offset = reserve(1 + sizeof(uint32_t) + text.size() + 1);
+    const auto size = static_cast<uint32_t>(text.size());
+    char* out = _buffer.data() + offset;
+    *out = static_cast<char>(type);
+    std::memcpy(out + 1, &size, sizeof(size));
+    std::memcpy(out + 1 + sizeof(size), text.data(), text.size());
+    out[1 + sizeof(size) + text.size()] = '\0';
+    return offset;
+}
+
+inline uint32_t frozen_value::builder::close_array(size_t first)
+{
+    const auto count = static_cast<uint32_t>(pending.size() - first);
+    const uint32_t offset = reserve(1 + sizeof(uint32_t) * (1 + size_t(count)));
+    char* out = _buffer.data() + offset;
+    *out = static_cast<char>(value::value_type::array);
+    std::memcpy(out + 1, &count, sizeof(count));
+    std::memcpy(out + 1 + sizeof(count), pending.data() + first, sizeof(uint32_t) * count);
+    pending.resize(first);
+    return offset;
+}
+
+inline std::optional<uint32_t> frozen_value::builder::close_object(size_t first)
+{
+    _members.clear();
+    for (size_t i = first; i < pending.size(); i += 2) {
+        _members.emplace_back(pending[i], pending[i + 1]);
+    }
+    pending.resize(first);
+
+    auto key_less = [this](const auto& lhs, const auto& rhs) { return key(lhs.first) < key(rhs.first); };
+    if (!std::is_sorted(_members.cbegin(), _members.cend(), key_less)) {
+        std::stable_sort(_members.begin(), _members.end(), key_less);
+    }
+    auto duplicate = std::adjacent_find(_members.cbegin(), _members.cend(), [this](const auto& lhs, const auto& rhs) {
+        return key(lhs.first) == key(rhs.first);
+    });
+    if (duplicate != _members.cend()) {
+        return std::nullopt;
+    }
+
+    const auto count = static_cast<uint32_t>(_members.size());
+    const uint32_t offset = reserve(1 + sizeof(uint32_t) * (1 + 2 * size_t(count)));
+    char* out = _buffer.data() + offset + 1;
+    _buffer[offset] = static_cast<char>(value::value_type::object);
+    std::memcpy(out, &count, sizeof(count));
+    out += sizeof(count);
+    for (const auto& [key, val] : _members) {
+        std::memcpy(out, &key, sizeof(key));
+        std::memcpy(out + sizeof(key), &val, sizeof(val));
+        out += 2 * sizeof(uint32_t);
+    }
+    return offset;
+}
+
+inline std::string_view frozen_value::builder::key(uint32_t offset) const noexcept
+{
+    uint32_t size = 0;
+    std::memcpy(&size, _buffer.data() + offset + 1, sizeof(size));
+    return std::string_view(_buffer.data() + offset + 1 + sizeof(size), size);
+}
+
+inline frozen_value frozen_value::builder::finish(uint32_t root)
+{
+    const auto size = static_cast<uint32_t>(_buffer.size());
+    std::memcpy(_buffer.data() + magic.size(), &size, sizeof(size));
+    std::memcpy(_buffer.data() + magic.size() + sizeof(size), &root, sizeof(root));
+
+    return frozen_value(std::move(_buffer));
+}
+
+// *************************
+// *       node impl       *
+// *************************
+
+inline uint32_t frozen_value::node::read_u32(uint32_t offset) const noexcept
+{
+    uint32_t result = 0;
+    std::memcpy(&result, _base + offset, sizeof(result));
+    return result;
+}
+
+inline std::string_view frozen_value::node::read_text(uint32_t offset) const noexcept
+{
+    return std::string_view(_base + offset + sizeof(uint32_t), read_u32(offset));
+}
+
+inline std::string frozen_value::node::info() const
+{
+    std::string_view name = _reflection::enum_to_string(type());
+    std::string result = "type=" + (name.empty() ? std::string("unknown") : std::string(name));
+    if (is_array() || is_object()) {
+        result += ", size=" + std::to_string(size());
+    }
+    return result;
+}
+
+inline value::value_type frozen_value::node::type() const noexcept
+{
+    return static_cast<value::value_type>(_base[_offset]);
+}
+
+inline bool frozen_value::node::as_boolean() const
+{
+    if (!is_boolean()) {
+        throw exception("Type error: cannot convert to boolean, expected=boolean, " + info());
+    }
+    return _base[_offset + 1] != 0;
+}
+
+inline int frozen_value::node::as_integer() const
+{
+    return _frozen_value_impl_detail::parse_integer<int>(as_number_text(), "integer");
+}
+
+inline long long frozen_value::node::as_long_long() const
+{
+    return _frozen_value_impl_detail::parse_integer<long long>(as_number_text(), "long long");
+}
+
+inline unsigned long long frozen_value::node::as_unsigned_long_long() const
+{
+    return _frozen_value_impl_detail::parse_integer<unsigned long long>(as_number_text(), "unsigned long long");
+}
+
+inline double frozen_value::node::as_double() const
+{
+    const std::string_view text = as_number_text();
+    double result = 0;
+    if (!_utils::parse_double(text, result)) {
+        throw exception("Parse error: cannot convert number '" + std::string(text) + "' to double");
+    }
+    return result;
+}
+
+inline std::string_view frozen_value::node::as_string() const
+{
+    if (!is_string()) {
+        throw exception("Type error: cannot convert to string, expected=string, " + info());
+    }
+    return read_text(_offset + 1);
+}
+
+inline std::string_view frozen_value::node::as_number_text() const
+{
+    if (!is_number()) {
+        throw exception("Type error: cannot convert to number, expected=number, " + info());
+    }
+    return read_text(_offset + 1);
+}
+
+inline size_t frozen_value::node::size() const noexcept
+{
+    return is_array() || is_object() ? read_u32(_offset + 1) : 0;
+}
+
+inline std::optional<frozen_value::node> frozen_value::node::find(size_t pos) const
+{
+    if (!is_array() || pos >= size()) {
+        return std::nullopt;
+    }
+    return node(_base, read_u32(table() + static_cast<uint32_t>(pos * sizeof(uint32_t))));
+}
+
+inline std::optional<frozen_value::node> frozen_value::node::find(std::string_view key) const
+{
+    if (!is_object()) {
+        return std::nullopt;
+    }
+    // binary search over the sorted member table
+    size_t low = 0;
+    size_t high = size();
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        const std::string_view mid_key = key_at(mid);
+        if (mid_key < key) {
+            low = mid + 1;
+        }
+        else if (key < mid_key) {
+            high = mid;
+        }
+        else {
+            return value_at(mid);
+        }
+    }
+    return std::nullopt;
+}
+
+inline frozen_value::node frozen_value::node::at(size_t pos) const
+{
+    if (!is_array()) {
+        throw exception("Type error: cannot convert to array, expected=array, " + info());
+    }
+    if (auto found = find(pos)) {
+        return *found;
+    }
+    throw exception("Out of range: index " + std::to_string(pos) + ", " + info());
+}
+
+inline frozen_value::node frozen_value::node::at(std::string_view key) const
+{
+    if (!is_object()) {
+        throw exception("Type error: cannot convert to object, expected=object, " + info());
+    }
+    if (auto found = find(key)) {
+        return *found;
+    }
+    throw exception("Out of range: key '" + std::string(key) + "' not found, " + info());
+}
+
+inline std::string_view frozen_value::node::key_at(size_t pos) const
+{
+    return node(_base, read_u32(table() + static_cast<uint32_t>(pos * 2 * sizeof(uint32_t)))).as_string();
+}
+
+inline frozen_value::node frozen_value::node::value_at(size_t pos) const
+{
+    return node(_base, read_u32(table() + static_cast<uint32_t>((pos * 2 + 1) * sizeof(uint32_t))));
+}
+
+inline value frozen_value::node::to_value() const
+{
+    value result;
+    std::vector<std::pair<node, value*>> pending { { *this, &result } };
+    while (!pending.empty()) {
+        const auto [src, dst] = pending.back();
+        pending.pop_back();
+
+        switch (src.type()) {
+        case value::value_type::boolean:
+            *dst = src.as_boolean();
+            break;
+        case value::value_type::number:
+            *dst = value(value::value_type::number, std::string(src.as_number_text()));
+            break;
+        case value::value_type::string:
+            *dst = std::string(src.as_string());
+            break;
+        case value::value_type::array: {
+            const size_t count = src.size();
+            *dst = array(count);
+            array& arr = dst->as_array();
+            for (size_t i = 0; i < count; ++i) {
+                pending.emplace_back(src.at(i), &arr[i]);
+            }
+            break;
+        }
+        case value::value_type::object: {
+            *dst = object();
+            object& obj = dst->as_object();
+            for (size_t i = 0; i < src.size(); ++i) {
+                pending.emplace_back(src.value_at(i), &obj[std::string(src.key_at(i))]);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return result;
+}
+} // namespace json
@@ -2,5 +2,7 @@
 #pragma once
 
 #include "array_impl.hpp"
+#include "frozen_value_impl.hpp"
 #include "object_impl.hpp"
+#include "persistent_value_impl.hpp"
 #include "value_impl.hpp"
@@ -2,14 +2,17 @@
 
 #pragma once
 
+#include <functional>
 #include <initializer_list>
 #include <map>
 #include <optional>
 #include <ostream>
 #include <string>
 #include <tuple>
+#include <vector>
 
 #include "exception.hpp"
+#include "segment_buffer.hpp"
 #include "utils.hpp"
 
 namespace json
@@ -20,7 +23,8 @@ class object
     friend class array;
 
 public:
-    using raw_object = std::map<std::string, value>;
+    // transparent, so members can be looked up by std::string_view without building a std::string
+    using raw_object = std::map<std::string, value, std::less<>>;
     using key_type = typename raw_object::key_type;
     using mapped_type = typename raw_object::mapped_type;
     using value_type = typename raw_object::value_type;
@@ -98,11 +102,24 @@ public:
 
     const value& at(const std::string& key) const;
 
-    std::string dumps(std::optional<size_t> indent = std::nullopt) const;
+    std::string dumps(std::optional<size_t> indent = std::nullopt, bool ensure_ascii = false) const;
 
     std::string to_string() const;
+    // Appends the compact form to out, reusing its capacity; see also json::serializer
+    void dump_to(std::string& out, bool ensure_ascii = false) const;
 
     std::string format(size_t indent = 4) const;
+    std::string format(const format_options& options) const;
+
+    // RFC 8785 JSON Canonicalization Scheme, for hashing and signing
+    std::string dumps_canonical() const;
+    void dump_canonical_to(std::string& out) const;
+    // sink is called with std::string_view chunks, e.g. a hash update, so the output is never materialized
+    template <typename sink_t, std::enable_if_t<std::is_invocable_v<sink_t&, std::string_view>, bool> = true>
+    void dump_canonical_to(sink_t&& sink) const;
+
+    // Appends the compact form as segments referencing this value's string storage, see segment_buffer
+    void dump_segments_to(segment_buffer& out) const;
 
     template <typename value_t>
     bool all() const;
@@ -227,12 +244,15 @@ private:
     template <typename value_t>
     auto get_helper(const value_t& default_value, const std::string& key) const;
 
-    void dump_to(std::string& out) const;
-    void format_to(std::string& out, size_t indent, size_t indent_times) const;
-
-    std::string format(size_t indent, size_t indent_times) const;
+    template <bool ensure_ascii = false, typename writer_t>
+    void write_compact(writer_t& out) const;
+    void format_to(std::string& out, _utils::indent_cache& indent, size_t indent_times) const;
+    size_t format_size(const format_options& options, size_t indent_times) const;
+    template <typename writer_t>
+    void write_canonical(writer_t& out) const;
 
 private:
     raw_object _object_data;
+    _utils::hash_cache _hash;
 };
 } // namespace json
@@ -13,10 +13,16 @@ inline void merge_object(object::raw_object& dst, const object& src)
     }
 }
 
-inline void merge_object_move(object::raw_object& dst, object& src)
+inline void merge_object_move(object::raw_object& dst, object::raw_object& src)
 {
+    if (dst.empty()) {
+        dst.swap(src);
+        return;
+    }
+    // Members missing in dst are spliced over without copying or allocating; the colliding ones stay in src
+    dst.merge(src);
     for (auto& [key, val] : src) {
-        dst.insert_or_assign(key, std::move(val));
+        dst.find(key)->second = std::move(val);
     }
 }
 } // namespace _object_impl_detail
@@ -88,16 +94,19 @@ inline const value& object::at(const std::string& key) const
 
 inline void object::clear() noexcept
 {
+    _hash.reset();
     _object_data.clear();
 }
 
 inline bool object::erase(const std::string& key)
 {
+    _hash.reset();
     return _object_data.erase(key) > 0 ? true : false;
 }
 
 inline bool object::erase(iterator iter)
 {
+    _hash.reset();
     if (iter == _object_data.end()) {
         return false;
     }
@@ -108,6 +117,7 @@ inline bool object::erase(iterator iter)
 template <typename... args_t>
 inline decltype(auto) object::emplace(args_t&&... args)
 {
+    _hash.reset();
     static_assert(std::is_constructible_v<value_type, args_t...>, "Parameter can't be used to construct a raw_object::value_type");
     return _object_data.insert_or_assign(std::forward<args_t>(args)...);
 }
@@ -121,64 +131,92 @@ inline decltype(auto) object::insert(args_t&&... args)
 inline std::string object::to_string() const
 {
     std::string str;
-    dump_to(str);
+    write_compact(str);
     return str;
 }
 
-inline void object::dump_to(std::string& out) const
+inline void object::dump_to(std::string& out, bool ensure_ascii) const
 {
-    out.push_back('{');
-    for (auto iter = _object_data.cbegin(); iter != _object_data.cend();) {
-        const auto& [key, val] = *iter;
-        out.push_back('"');
-        _utils::append_escaped_string(out, key);
-        out.push_back('"');
-        out.push_back(':');
-        val.dump_to(out);
-        if (++iter != _object_data.cend()) {
-            out.push_back(',');
-        }
+    if (ensure_ascii) {
+        write_compact<true>(out);
     }
-    out.push_back('}');
+    else {
+        write_compact(out);
+    }
+}
+
+template <bool ensure_ascii, typename writer_t>
+inline void object::write_compact(writer_t& out) const
+{
+    value::write_compact_tree<ensure_ascii>(out, nullptr, this);
+}
+
+inline void object::format_to(std::string& out, _utils::indent_cache& indent, size_t indent_times) const
+{
+    value::format_tree(out, indent, nullptr, this, indent_times);
 }
 
-inline std::string object::format(size_t indent, size_t indent_times) const
+inline size_t object::format_size(const format_options& options, size_t indent_times) const
 {
+    return value::format_size_tree(options, nullptr, this, indent_times);
+}
+
+inline std::string object::dumps(std::optional<size_t> indent, bool ensure_ascii) const
+{
+    if (indent) {
+        format_options options;
+        options.indent = *indent;
+        options.ensure_ascii = ensure_ascii;
+        return format(options);
+    }
     std::string str;
-    format_to(str, indent, indent_times);
+    dump_to(str, ensure_ascii);
     return str;
 }
 
-inline void object::format_to(std::string& out, size_t indent, size_t indent_times) const
-{
-    out.push_back('{');
-    out.push_back('\n');
-    for (auto iter = _object_data.cbegin(); iter != _object_data.cend();) {
-        const auto& [key, val] = *iter;
-        out.append(indent * (indent_times + 1), ' ');
-        out.push_back('"');
-        _utils::append_escaped_string(out, key);
-        out.push_back('"');
-        out.push_back(':');
-        out.push_back(' ');
-        val.format_to(out, indent, indent_times + 1);
-        if (++iter != _object_data.cend()) {
-            out.push_back(',');
-        }
-        out.push_back('\n');
-    }
-    out.append(indent * indent_times, ' ');
-    out.push_back('}');
+inline std::string object::format(size_t indent) const
+{
+    return format(format_options { indent });
 }
 
-inline std::string object::dumps(std::optional<size_t> indent) const
+inline std::string object::format(const format_options& options) const
 {
-    return indent ? format(*indent) : to_string();
+    std::string str;
+    str.reserve(format_size(options, 0));
+    _utils::indent_cache indent(options);
+    format_to(str, indent, 0);
+    return str;
 }
 
-inline std::string object::format(size_t indent) const
+inline std::string object::dumps_canonical() const
+{
+    std::string str;
+    dump_canonical_to(str);
+    return str;
+}
+
+inline void object::dump_canonical_to(std::string& out) const
+{
+    write_canonical(out);
+}
+
+template <typename sink_t, std::enable_if_t<std::is_invocable_v<sink_t&, std::string_view>, bool>>
+inline void object::dump_canonical_to(sink_t&& sink) const
 {
-    return format(indent, 0);
+    _utils::callback_writer<std::remove_reference_t<sink_t>> writer(sink);
+    write_canonical(writer);
+    writer.flush();
+}
+
+inline void object::dump_segments_to(segment_buffer& out) const
+{
+    write_compact(out);
+}
+
+template <typename writer_t>
+inline void object::write_canonical(writer_t& out) const
+{
+    value::write_canonical_tree(out, nullptr, this);
 }
 
 template <typename value_t>
@@ -245,11 +283,13 @@ inline const value* object::find_value(const std::string& key) const
 
 inline typename object::iterator object::begin() noexcept
 {
+    _hash.reset();
     return _object_data.begin();
 }
 
 inline typename object::iterator object::end() noexcept
 {
+    _hash.reset();
     return _object_data.end();
 }
 
@@ -275,11 +315,13 @@ inline typename object::const_iterator object::cend() const noexcept
 
 inline value& object::operator[](const std::string& key)
 {
+    _hash.reset();
     return _object_data[key];
 }
 
 inline value& object::operator[](std::string&& key)
 {
+    _hash.reset();
     return _object_data[std::move(key)];
 }
 
@@ -292,32 +334,42 @@ inline object object::operator|(const object& rhs) const&
 
 inline object object::operator|(object&& rhs) const&
 {
-    object temp = *this;
-    _object_impl_detail::merge_object_move(temp._object_data, rhs);
+    // keep rhs and only copy the members it does not override
+    object temp = std::move(rhs);
+    auto hint = temp._object_data.begin();
+    for (const auto& [key, val] : _object_data) {
+        hint = std::next(temp._object_data.try_emplace(hint, key, val));
+    }
     return temp;
 }
 
 inline object object::operator|(const object& rhs) &&
 {
+    _hash.reset();
     _object_impl_detail::merge_object(_object_data, rhs);
     return std::move(*this);
 }
 
 inline object object::operator|(object&& rhs) &&
 {
-    _object_impl_detail::merge_object_move(_object_data, rhs);
+    _hash.reset();
+    rhs._hash.reset();
+    _object_impl_detail::merge_object_move(_object_data, rhs._object_data);
     return std::move(*this);
 }
 
 inline object& object::operator|=(const object& rhs)
 {
+    _hash.reset();
     _object_impl_detail::merge_object(_object_data, rhs);
     return *this;
 }
 
 inline object& object::operator|=(object&& rhs)
 {
-    _object_impl_detail::merge_object_move(_object_data, rhs);
+    _hash.reset();
+    rhs._hash.reset();
+    _object_impl_detail::merge_object_move(_object_data, rhs._object_data);
     return *this;
 }
 
@@ -343,7 +395,7 @@ inline T object::as() const&
     if constexpr (_utils::is_map<T> && std::is_same_v<typename T::key_type, std::string>) {
         T result;
         for (const auto& [key, val] : _object_data) {
-            result.emplace(key, val.as<typename T::mapped_type>());
+            result.emplace(key, val.template as<typename T::mapped_type>());
         }
         return result;
     }
@@ -358,7 +410,7 @@ inline T object::as() &&
     if constexpr (_utils::is_map<T> && std::is_same_v<typename T::key_type, std::string>) {
         T result;
         for (auto& [key, val] : _object_data) {
-            result.emplace(key, std::move(val).as<typename T::mapped_type>());
+            result.emplace(key, std::move(val).template as<typename T::mapped_type>());
         }
         return result;
     }
@@ -0,0 +1,195 @@
+// IWYU pragma: private, include <meojson/json.hpp>
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "value.hpp"
+
+namespace json
+{
+namespace _persistent
+{
+// Immutable sequence stored as a B-tree of chunks holding at most chunk_width entries or children.
+// Every update copies the one chunk per level on the way to the change, O(chunk_width * log(n)), and
+// shares all other chunks with the source list.
+template <typename entry_t>
+class chunk_list
+{
+public:
+    static constexpr size_t chunk_width = 32;
+
+    chunk_list() = default;
+    explicit chunk_list(std::vector<entry_t> entries);
+
+    chunk_list(const chunk_list&) = default;
+    chunk_list(chunk_list&& rhs) noexcept;
+    chunk_list& operator=(const chunk_list&) = default;
+    chunk_list& operator=(chunk_list&& rhs) noexcept;
+
+    size_t size() const noexcept { return _size; }
+
+    bool empty() const noexcept { return _size == 0; }
+
+    // pos must be less than size()
+    const entry_t& operator[](size_t pos) const;
+
+    // First position whose entry is not less(entry, probe); the entries must be sorted by less
+    template <typename probe_t, typename less_t>
+    size_t lower_bound(const probe_t& probe, less_t less) const;
+
+    chunk_list set(size_t pos, entry_t entry) const;
+    chunk_list insert(size_t pos, entry_t entry) const;
+    chunk_list erase(size_t pos) const;
+
+    template <typename func_t>
+    void for_each(func_t&& func) const;
+
+    // Both lists are the same stored chunks, e.g. a version and the untouched subtree of its successor
+    bool shares(const chunk_list& rhs) const noexcept { return _root == rhs._root; }
+
+private:
+    struct node;
+    using node_ptr = std::shared_ptr<const node>;
+
+    chunk_list(node_ptr root, size_t size);
+
+    static node_ptr make_leaf(std::vector<entry_t> entries);
+    static node_ptr make_inner(std::vector<node_ptr> children);
+
+    // Child holding pos, with pos made relative to it
+    static size_t locate(const node& parent, size_t& pos) noexcept;
+
+    static node_ptr set_at(const node& target, size_t pos, entry_t&& entry);
+    static std::pair<node_ptr, node_ptr> insert_at(const node& target, size_t pos, entry_t&& entry);
+    static node_ptr erase_at(const node& target, size_t pos);
+
+    template <typename func_t>
+    static void for_each_in(const node& target, func_t& func);
+
+    node_ptr _root;
+    size_t _size = 0;
+};
+} // namespace _persistent
+
+// Immutable json document for keeping many versions around.
+// Copies are O(1), and set() / erase() return a new version that shares every untouched subtree with
+// this one. Arrays and objects are chunked B-trees (objects kept sorted by key, as in json::object),
+// so a change copies O(32 * log(width)) entries per nesting level on its path, and N versions cost the
+// size of their diffs rather than N documents.
+// Reads mirror the const json::value interface. Conversions and destruction recurse once per nesting level.
+// Paths are JSON pointers, e.g. /servers/0/port.
+class persistent_value
+{
+public:
+    using value_type = value::value_type;
+    using member = std::pair<std::string, persistent_value>;
+
+    persistent_value() = default;
+    explicit persistent_value(const value& val);
+
+    persistent_value(const persistent_value&) = default;
+    persistent_value(persistent_value&&) noexcept = default;
+    persistent_value& operator=(const persistent_value&) = default;
+    persistent_value& operator=(persistent_value&&) noexcept = default;
+
+    bool valid() const noexcept { return _type != value_type::invalid; }
+
+    bool is_null() const noexcept { return _type == value_type::null; }
+
+    bool is_number() const noexcept { return _type == value_type::number; }
+
+    bool is_boolean() const noexcept { return _type == value_type::boolean; }
+
+    bool is_string() const noexcept { return _type == value_type::string; }
+
+    bool is_array() const noexcept { return _type == value_type::array; }
+
+    bool is_object() const noexcept { return _type == value_type::object; }
+
+    value_type type() const noexcept { return _type; }
+
+    // Elements or members; 0 for anything else
+    size_t size() const noexcept;
+
+    bool empty() const noexcept;
+
+    bool contains(const std::string& key) const;
+    bool contains(size_t pos) const;
+
+    const persistent_value& at(size_t pos) const;
+    const persistent_value& at(const std::string& key) const;
+
+    const persistent_value* find_value(size_t pos) const;
+    const persistent_value* find_value(const std::string& key) const;
+
+    // nullptr if the path does not exist
+    const persistent_value* find(std::string_view pointer) const;
+
+    bool as_boolean() const;
+    int as_integer() const;
+    long long as_long_long() const;
+    unsigned long long as_unsigned_long_long() const;
+    double as_double() const;
+    std::string as_string() const;
+    std::string_view as_string_view() const;
+
+    // Scalars convert directly, arrays and objects through to_value()
+    template <typename value_t>
+    value_t as() const;
+
+    // func(const persistent_value&) for each element, in order
+    template <typename func_t>
+    void for_each_element(func_t&& func) const;
+
+    // func(const std::string&, const persistent_value&) for each member, sorted by key
+    template <typename func_t>
+    void for_each_member(func_t&& func) const;
+
+    // New version with the value at pointer replaced. Missing object members on the way are created,
+    // and "-" as the last array segment appends.
+    persistent_value set(std::string_view pointer, value val) const;
+
+    // New version without the value at pointer; unchanged (but still O(1)) if it does not exist
+    persistent_value erase(std::string_view pointer) const;
+
+    // True when both are the same stored array or object, i.e. a subtree left untouched between versions.
+    // O(1), unlike operator==; false for scalars
+    bool shares(const persistent_value& rhs) const noexcept;
+
+    // Independent deep copy
+    value to_value() const;
+
+    std::string to_string() const { return to_value().to_string(); }
+
+    std::string value_info() const noexcept;
+
+    bool operator==(const persistent_value& rhs) const;
+
+    bool operator!=(const persistent_value& rhs) const { return !(*this == rhs); }
+
+private:
+    // This node with segments[pos..] replaced by val, or erased if val is nullptr
+    persistent_value updated(const std::vector<std::string>& segments, size_t pos, const persistent_value* val) const;
+
+    size_t member_position(const std::string& key) const;
+
+    // The value for the scalar accessors; throws for arrays and objects
+    const value& scalar() const;
+
+    static std::vector<std::string> split(std::string_view pointer);
+
+    static bool parse_index(const std::string& segment, size_t& index);
+
+    value_type _type = value_type::null;
+    // null, boolean, number or string
+    value _scalar;
+    _persistent::chunk_list<persistent_value> _elements;
+    _persistent::chunk_list<member> _members;
+};
+} // namespace json
@@ -0,0 +1,674 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+
+#include "exception.hpp"
+#include "persistent_value.hpp"
+
+namespace json
+{
+namespace _persistent
+{
+template <typename entry_t>
+struct chunk_list<entry_t>::node
+{
+    bool leaf = true;
+    size_t total = 0;
+
+    // leaves
+    std::vector<entry_t> entries;
+
+    // inner nodes: children with their entry counts and last entries, for locate() and lower_bound()
+    std::vector<node_ptr> children;
+    std::vector<size_t> counts;
+    std::vector<const entry_t*> lasts;
+
+    size_t width() const noexcept { return leaf ? entries.size() : children.size(); }
+
+    const entry_t* last() const noexcept { return leaf ? &entries.back() : lasts.back(); }
+};
+
+template <typename entry_t>
+inline chunk_list<entry_t>::chunk_list(std::vector<entry_t> entries)
+    : _size(entries.size())
+{
+    if (entries.empty()) {
+        return;
+    }
+
+    // bottom-up with full chunks, O(n)
+    std::vector<node_ptr> level;
+    for (size_t begin = 0; begin < entries.size(); begin += chunk_width) {
+        const size_t end = std::min(begin + chunk_width, entries.size());
+        level.emplace_back(
+            make_leaf(std::vector<entry_t>(std::make_move_iterator(entries.begin() + begin), std::make_move_iterator(entries.begin() + end))));
+    }
+    while (level.size() > 1) {
+        std::vector<node_ptr> parents;
+        for (size_t begin = 0; begin < level.size(); begin += chunk_width) {
+            const size_t end = std::min(begin + chunk_width, level.size());
+            parents.emplace_back(
+                make_inner(std::vector<node_ptr>(std::make_move_iterator(level.begin() + begin), std::make_move_iterator(level.begin() + end))));
+        }
+        level = std::move(parents);
+    }
+    _root = std::move(level.front());
+}
+
+template <typename entry_t>
+inline chunk_list<entry_t>::chunk_list(chunk_list&& rhs) noexcept
+    : _root(std::move(rhs._root))
+    , _size(std::exchange(rhs._size, 0))
+{
+}
+
+template <typename entry_t>
+inline chunk_list<entry_t>& chunk_list<entry_t>::operator=(chunk_list&& rhs) noexcept
+{
+    _root = std::move(rhs._root);
+    _size = std::exchange(rhs._size, 0);
+    return *this;
+}
+
+template <typename entry_t>
+inline chunk_list<entry_t>::chunk_list(node_ptr root, size_t size)
+    : _root(std::move(root))
+    , _size(size)
+{
+}
+
+template <typename entry_t>
+inline const entry_t& chunk_list<entry_t>::operator[](size_t pos) const
+{
+    const node* target = _root.get();
+    while (!target->leaf) {
+        target = target->children[locate(*target, pos)].get();
+    }
+    return target->entries[pos];
+}
+
+template <typename entry_t>
+template <typename probe_t, typename less_t>
+inline size_t chunk_list<entry_t>::lower_bound(const probe_t& probe, less_t less) const
+{
+    const node* target = _root.get();
+    if (!target) {
+        return 0;
+    }
+
+    size_t base = 0;
+    while (!target->leaf) {
+        size_t i = 0;
+        while (i + 1 < target->children.size() && less(*target->lasts[i], probe)) {
+            base += target->counts[i];
+            ++i;
+        }
+        target = target->children[i].get();
+    }
+    return base + static_cast<size_t>(std::lower_bound(target->entries.begin(), target->entries.end(), probe, less) - target->entries.begin());
+}
+
+template <typename entry_t>
+inline chunk_list<entry_t> chunk_list<entry_t>::set(size_t pos, entry_t entry) const
+{
+    return chunk_list(set_at(*_root, pos, std::move(entry)), _size);
+}
+
+template <typename entry_t>
+inline chunk_list<entry_t> chunk_list<entry_t>::insert(size_t pos, entry_t entry) const
+{
+    if (!_root) {
+        std::vector<entry_t> entries;
+        entries.emplace_back(std::move(entry));
+        return chunk_list(make_leaf(std::move(entries)), 1);
+    }
+
+    auto [root, split] = insert_at(*_root, pos, std::move(entry));
+    if (split) {
+        root = make_inner({ std::move(root), std::move(split) });
+    }
+    return chunk_list(std::move(root), _size + 1);
+}
+
+template <typename entry_t>
+inline chunk_list<entry_t> chunk_list<entry_t>::erase(size_t pos) const
+{
+    node_ptr root = erase_at(*_root, pos);
+    while (root && !root->leaf && root->children.size() == 1) {
+        root = root->children.front();
+    }
+    return chunk_list(std::move(root), _size - 1);
+}
+
+template <typename entry_t>
+template <typename func_t>
+inline void chunk_list<entry_t>::for_each(func_t&& func) const
+{
+    if (_root) {
+        for_each_in(*_root, func);
+    }
+}
+
+template <typename entry_t>
+inline typename chunk_list<entry_t>::node_ptr chunk_list<entry_t>::make_leaf(std::vector<entry_t> entries)
+{
+    auto result = std::make_shared<node>();
+    result->total = entries.size();
+    result->entries = std::move(entries);
+    return result;
+}
+
+template <typename entry_t>
+inline typename chunk_list<entry_t>::node_ptr chunk_list<entry_t>::make_inner(std::vector<node_ptr> children)
+{
+    auto result = std::make_shared<node>();
+    result->leaf = false;
+    result->counts.reserve(children.size());
+    result->lasts.reserve(children.size());
+    for (const node_ptr& child : children) {
+        result->total += child->total;
+        result->counts.emplace_back(child->total);
+        result->lasts.emplace_back(child->last());
+    }
+    result->children = std::move(children);
+    return result;
+}
+
+template <typename entry_t>
+inline size_t chunk_list<entry_t>::locate(const node& parent, size_t& pos) noexcept
+{
+    // pos == total, i.e. appending, lands at the end of the last child
+    size_t i = 0;
+    while (i + 1 < parent.children.size() && pos >= parent.counts[i]) {
+        pos -= parent.counts[i];
+        ++i;
+    }
+    return i;
+}
+
+template <typename entry_t>
+inline typename chunk_list<entry_t>::node_ptr chunk_list<entry_t>::set_at(const node& target, size_t pos, entry_t&& entry)
+{
+    auto result = std::make_shared<node>(target);
+    if (result->leaf) {
+        result->entries[pos] = std::move(entry);
+    }
+    else {
+        const size_t i = locate(*result, pos);
+        result->children[i] = set_at(*result->children[i], pos, std::move(entry));
+        result->lasts[i] = result->children[i]->last();
+    }
+    return result;
+}
+
+template <typename entry_t>
+inline std::pair<typename chunk_list<entry_t>::node_ptr, typename chunk_list<entry_t>::node_ptr>
+    chunk_list<entry_t>::insert_at(const node& target, size_t pos, entry_t&& entry)
+{
+    // a chunk that overflows is split in halves, and the upper half becomes a new sibling
+    if (target.leaf) {
+        std::vector<entry_t> entries;
+        entries.reserve(target.entries.size() + 1);
+        entries.insert(entries.end(), target.entries.begin(), target.entries.begin() + pos);
+        entries.emplace_back(std::move(entry));
+        entries.insert(entries.end(), target.entries.begin() + pos, target.entries.end());
+        if (entries.size() <= chunk_width) {
+            return { make_leaf(std::move(entries)), nullptr };
+        }
+        const auto half = entries.begin() + entries.size() / 2;
+        std::vector<entry_t> upper(std::make_move_iterator(half), std::make_move_iterator(entries.end()));
+        entries.erase(half, entries.end());
+        return { make_leaf(std::move(entries)), make_leaf(std::move(upper)) };
+    }
+
+    std::vector<node_ptr> children = target.children;
+    const size_t i = locate(target, pos);
+    auto [child, split] = insert_at(*children[i], pos, std::move(entry));
+    children[i] = std::move(child);
+    if (split) {
+        children.insert(children.begin() + i + 1, std::move(split));
+    }
+    if (children.size() <= chunk_width) {
+        return { make_inner(std::move(children)), nullptr };
+    }
+    const auto half = children.begin() + children.size() / 2;
+    std::vector<node_ptr> upper(std::make_move_iterator(half), std::make_move_iterator(children.end()));
+    children.erase(half, children.end());
+    return { make_inner(std::move(children)), make_inner(std::move(upper)) };
+}
+
+template <typename entry_t>
+inline typename chunk_list<entry_t>::node_ptr chunk_list<entry_t>::erase_at(const node& target, size_t pos)
+{
+    // nullptr once the chunk is empty, so the parent drops it
+    if (target.leaf) {
+        if (target.entries.size() == 1) {
+            return nullptr;
+        }
+        std::vector<entry_t> entries;
+        entries.reserve(target.entries.size() - 1);
+        entries.insert(entries.end(), target.entries.begin(), target.entries.begin() + pos);
+        entries.insert(entries.end(), target.entries.begin() + pos + 1, target.entries.end());
+        return make_leaf(std::move(entries));
+    }
+
+    std::vector<node_ptr> children = target.children;
+    const size_t i = locate(target, pos);
+    node_ptr child = erase_at(*children[i], pos);
+    if (!child) {
+        children.erase(children.begin() + i);
+        if (children.empty()) {
+            return nullptr;
+        }
+        return make_inner(std::move(children));
+    }
+    children[i] = std::move(child);
+
+    // merged with a neighbour when both fit in one chunk, so that erasing does not leave the tree sparse
+    if (children.size() > 1) {
+        const size_t first = i + 1 < children.size() ? i : i - 1;
+        const node& lower = *children[first];
+        const node& upper = *children[first + 1];
+        if (lower.width() + upper.width() <= chunk_width) {
+            node_ptr merged;
+            if (lower.leaf) {
+                std::vector<entry_t> entries = lower.entries;
+                entries.insert(entries.end(), upper.entries.begin(), upper.entries.end());
+                merged = make_leaf(std::move(entries));
+            }
+            else {
+                std::vector<node_ptr> grandchildren = lower.children;
+                grandchildren.insert(grandchildren.end(), upper.children.begin(), upper.children.end());
+                merged = make_inner(std::move(grandchildren));
+            }
+            children[first] = std::move(merged);
+            children.erase(children.begin() + first + 1);
+        }
+    }
+    return make_inner(std::move(children));
+}
+
+template <typename entry_t>
+template <typename func_t>
+inline void chunk_list<entry_t>::for_each_in(const node& target, func_t& func)
+{
+    if (target.leaf) {
+        for (const entry_t& entry : target.entries) {
+            func(entry);
+        }
+        return;
+    }
+    for (const node_ptr& child : target.children) {
+        for_each_in(*child, func);
+    }
+}
+} // namespace _persistent
+
+inline persistent_value::persistent_value(const value& val)
+    : _type(val.type())
+{
+    if (val.is_array()) {
+        std::vector<persistent_value> elements;
+        elements.reserve(val.as_array().size());
+        for (const value& elem : val.as_array()) {
+            elements.emplace_back(elem);
+        }
+        _elements = _persistent::chunk_list<persistent_value>(std::move(elements));
+    }
+    else if (val.is_object()) {
+        // json::object is sorted by key already
+        std::vector<member> members;
+        members.reserve(val.as_object().size());
+        for (const auto& [key, elem] : val.as_object()) {
+            members.emplace_back(key, persistent_value(elem));
+        }
+        _members = _persistent::chunk_list<member>(std::move(members));
+    }
+    else {
+        _scalar = val;
+    }
+}
+
+inline size_t persistent_value::size() const noexcept
+{
+    if (is_array()) {
+        return _elements.size();
+    }
+    if (is_object()) {
+        return _members.size();
+    }
+    return 0;
+}
+
+inline bool persistent_value::empty() const noexcept
+{
+    return is_array() || is_object() ? size() == 0 : _scalar.empty();
+}
+
+inline bool persistent_value::contains(const std::string& key) const
+{
+    return find_value(key) != nullptr;
+}
+
+inline bool persistent_value::contains(size_t pos) const
+{
+    return is_array() && pos < _elements.size();
+}
+
+inline const persistent_value& persistent_value::at(size_t pos) const
+{
+    if (!is_array()) {
+        throw exception("Type error: cannot convert to array, expected=array, " + value_info());
+    }
+    if (pos >= _elements.size()) {
+        throw std::out_of_range("persistent_value::at: index " + std::to_string(pos) + " out of range");
+    }
+    return _elements[pos];
+}
+
+inline const persistent_value& persistent_value::at(const std::string& key) const
+{
+    if (!is_object()) {
+        throw exception("Type error: cannot convert to object, expected=object, " + value_info());
+    }
+    const persistent_value* result = find_value(key);
+    if (!result) {
+        throw std::out_of_range("persistent_value::at: key \"" + key + "\" not found");
+    }
+    return *result;
+}
+
+inline const persistent_value* persistent_value::find_value(size_t pos) const
+{
+    return contains(pos) ? &_elements[pos] : nullptr;
+}
+
+inline const persistent_value* persistent_value::find_value(const std::string& key) const
+{
+    if (!is_object()) {
+        return nullptr;
+    }
+    const size_t pos = member_position(key);
+    return pos < _members.size() && _members[pos].first == key ? &_members[pos].second : nullptr;
+}
+
+inline const persistent_value* persistent_value::find(std::string_view pointer) const
+{
+    const persistent_value* node = this;
+    for (const auto& segment : split(pointer)) {
+        if (node->is_object()) {
+            node = node->find_value(segment);
+        }
+        else if (node->is_array()) {
+            size_t index = 0;
+            node = parse_index(segment, index) ? node->find_value(index) : nullptr;
+        }
+        else {
+            node = nullptr;
+        }
+        if (!node) {
+            return nullptr;
+        }
+    }
+    return node;
+}
+
+inline bool persistent_value::as_boolean() const
+{
+    return scalar().as_boolean();
+}
+
+inline int persistent_value::as_integer() const
+{
+    return scalar().as_integer();
+}
+
+inline long long persistent_value::as_long_long() const
+{
+    return scalar().as_long_long();
+}
+
+inline unsigned long long persistent_value::as_unsigned_long_long() const
+{
+    return scalar().as_unsigned_long_long();
+}
+
+inline double persistent_value::as_double() const
+{
+    return scalar().as_double();
+}
+
+inline std::string persistent_value::as_string() const
+{
+    return scalar().as_string();
+}
+
+inline std::string_view persistent_value::as_string_view() const
+{
+    return scalar().as_string_view();
+}
+
+template <typename value_t>
+inline value_t persistent_value::as() const
+{
+    if (is_array() || is_object()) {
+        return to_value().as<value_t>();
+    }
+    return _scalar.as<value_t>();
+}
+
+template <typename func_t>
+inline void persistent_value::for_each_element(func_t&& func) const
+{
+    if (!is_array()) {
+        throw exception("Type error: cannot convert to array, expected=array, " + value_info());
+    }
+    _elements.for_each(func);
+}
+
+template <typename func_t>
+inline void persistent_value::for_each_member(func_t&& func) const
+{
+    if (!is_object()) {
+        throw exception("Type error: cannot convert to object, expected=object, " + value_info());
+    }
+    _members.for_each([&](const member& entry) { func(entry.first, entry.second); });
+}
+
+inline persistent_value persistent_value::set(std::string_view pointer, value val) const
+{
+    const persistent_value replacement(val);
+    return updated(split(pointer), 0, &replacement);
+}
+
+inline persistent_value persistent_value::erase(std::string_view pointer) const
+{
+    auto segments = split(pointer);
+    if (segments.empty()) {
+        return persistent_value();
+    }
+    if (!find(pointer)) {
+        return *this;
+    }
+    return updated(segments, 0, nullptr);
+}
+
+inline bool persistent_value::shares(const persistent_value& rhs) const noexcept
+{
+    if (_type != rhs._type) {
+        return false;
+    }
+    if (is_array()) {
+        return _elements.shares(rhs._elements);
+    }
+    if (is_object()) {
+        return _members.shares(rhs._members);
+    }
+    return false;
+}
+
+inline value persistent_value::to_value() const
+{
+    if (is_array()) {
+        array result;
+        _elements.for_each([&](const persistent_value& elem) { result.emplace_back(elem.to_value()); });
+        return result;
+    }
+    if (is_object()) {
+        object result;
+        _members.for_each([&](const member& entry) { result.emplace(entry.first, entry.second.to_value()); });
+        return result;
+    }
+    return _scalar;
+}
+
+inline std::string persistent_value::value_info() const noexcept
+{
+    if (is_array()) {
+        return "type=array, size=" + std::to_string(_elements.size());
+    }
+    if (is_object()) {
+        return "type=object, size=" + std::to_string(_members.size());
+    }
+    return _scalar.value_info();
+}
+
+inline bool persistent_value::operator==(const persistent_value& rhs) const
+{
+    if (_type != rhs._type) {
+        return false;
+    }
+    if (shares(rhs)) {
+        return true;
+    }
+    if (is_array()) {
+        if (_elements.size() != rhs._elements.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < _elements.size(); ++i) {
+            if (_elements[i] != rhs._elements[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (is_object()) {
+        if (_members.size() != rhs._members.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < _members.size(); ++i) {
+            if (_members[i] != rhs._members[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return _scalar == rhs._scalar;
+}
+
+inline persistent_value persistent_value::updated(const std::vector<std::string>& segments, size_t pos, const persistent_value* val) const
+{
+    if (pos == segments.size()) {
+        return *val;
+    }
+
+    const std::string& segment = segments[pos];
+    const bool last = pos + 1 == segments.size();
+    persistent_value result(*this);
+    if (is_array()) {
+        size_t index = 0;
+        if (last && val && segment == "-") {
+            result._elements = _elements.insert(_elements.size(), *val);
+        }
+        else if (!parse_index(segment, index) || index >= _elements.size()) {
+            throw exception("Path error: array index out of range, " + segment);
+        }
+        else if (last && !val) {
+            result._elements = _elements.erase(index);
+        }
+        else {
+            result._elements = _elements.set(index, _elements[index].updated(segments, pos + 1, val));
+        }
+    }
+    else if (is_object() || is_null()) {
+        result._type = value_type::object;
+        const size_t index = member_position(segment);
+        const bool found = index < _members.size() && _members[index].first == segment;
+        if (last && !val) {
+            result._members = _members.erase(index);
+        }
+        else if (found) {
+            result._members = _members.set(index, member(segment, _members[index].second.updated(segments, pos + 1, val)));
+        }
+        else {
+            result._members = _members.insert(index, member(segment, persistent_value().updated(segments, pos + 1, val)));
+        }
+    }
+    else {
+        throw exception("Path error: not an array or object, " + value_info());
+    }
+    return result;
+}
+
+inline size_t persistent_value::member_position(const std::string& key) const
+{
+    return _members.lower_bound(key, [](const member& entry, const std::string& probe) { return entry.first < probe; });
+}
+
+inline const value& persistent_value::scalar() const
+{
+    if (is_array() || is_object()) {
+        throw exception("Type error: not a scalar, " + value_info());
+    }
+    return _scalar;
+}
+
+inline std::vector<std::string> persistent_value::split(std::string_view pointer)
+{
+    std::vector<std::string> segments;
+    if (pointer.empty()) {
+        return segments;
+    }
+    if (pointer.front() != '/') {
+        throw exception("Path error: JSON pointer must start with '/', " + std::string(pointer));
+    }
+    for (size_t pos = 1;;) {
+        const size_t end = std::min(pointer.find('/', pos), pointer.size());
+        std::string segment;
+        for (size_t i = pos; i < end; ++i) {
+            if (pointer[i] == '~' && i + 1 < end && (pointer[i + 1] == '0' || pointer[i + 1] == '1')) {
+                segment.push_back(pointer[++i] == '0' ? '~' : '/');
+            }
+            else {
+                segment.push_back(pointer[i]);
+            }
+        }
+        segments.emplace_back(std::move(segment));
+        if (end == pointer.size()) {
+            break;
+        }
+        pos = end + 1;
+    }
+    return segments;
+}
+
+inline bool persistent_value::parse_index(const std::string& segment, size_t& index)
+{
+    if (segment.empty() || (segment.size() > 1 && segment.front() == '0')) {
+        return false;
+    }
+    const char* end = segment.data() + segment.size();
+    auto [ptr, ec] = std::from_chars(segment.data(), end, index);
+    return ec == std::errc() && ptr == end;
+}
+
+inline std::ostream& operator<<(std::ostream& out, const persistent_value& val)
+{
+    out << val.to_value().format();
+    return out;
+}
+} // namespace json
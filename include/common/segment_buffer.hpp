@@ -0,0 +1,92 @@
+// IWYU pragma: private, include <meojson/json.hpp>
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json
+{
+// Serialized output as a list of byte ranges that can be handed to writev() or similar.
+// Long unescaped runs point straight into the strings of the serialized value, which must stay
+// alive and unmodified while the segments are in use; punctuation, escapes and short runs are
+// copied into an internal scratch buffer.
+class segment_buffer
+{
+public:
+    explicit segment_buffer(size_t min_ref_size = 64)
+        : _min_ref_size(min_ref_size)
+    {
+    }
+
+    size_t size() const noexcept { return _size; }
+
+    bool empty() const noexcept { return _size == 0; }
+
+    void clear() noexcept
+    {
+        _scratch.clear();
+        _ranges.clear();
+        _size = 0;
+    }
+
+    // Views are only valid until the next write to this buffer
+    std::vector<std::string_view> segments() const
+    {
+        std::vector<std::string_view> result;
+        result.reserve(_ranges.size());
+        for (const auto& r : _ranges) {
+            result.emplace_back(r.data ? r.data : _scratch.data() + r.offset, r.size);
+        }
+        return result;
+    }
+
+    std::string to_string() const
+    {
+        std::string result;
+        result.reserve(_size);
+        for (const auto& seg : segments()) {
+            result.append(seg);
+        }
+        return result;
+    }
+
+    // Writer interface used by the serializer: appended data must outlive the buffer
+    void append(const char* data, size_t len)
+    {
+        if (len < _min_ref_size) {
+            copy(data, len);
+            return;
+        }
+        _ranges.push_back(range { data, 0, len });
+        _size += len;
+    }
+
+    void push_back(char ch) { copy(&ch, 1); }
+
+private:
+    struct range
+    {
+        // nullptr for data in _scratch
+        const char* data = nullptr;
+        size_t offset = 0;
+        size_t size = 0;
+    };
+
+    void copy(const char* data, size_t len)
+    {
+        if (_ranges.empty() || _ranges.back().data) {
+            _ranges.push_back(range { nullptr, _scratch.size(), 0 });
+        }
+        _scratch.append(data, len);
+        _ranges.back().size += len;
+        _size += len;
+    }
+
+    size_t _min_ref_size = 0;
+    std::string _scratch;
+    std::vector<range> _ranges;
+    size_t _size = 0;
+};
+} // namespace json
@@ -0,0 +1,49 @@
+// IWYU pragma: private, include <meojson/json.hpp>
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace json
+{
+// Reusable output buffer for serializing many small documents.
+// The buffer keeps its capacity between calls, so once it has grown to the largest message
+// serialization no longer allocates.
+class serializer
+{
+public:
+    serializer() = default;
+
+    explicit serializer(size_t reserve) { _buffer.reserve(reserve); }
+
+    // json_t is json::value, json::array or json::object.
+    // The view is only valid until the next call on this serializer.
+    template <typename json_t>
+    std::string_view dump(const json_t& j, bool ensure_ascii = false)
+    {
+        _buffer.clear();
+        j.dump_to(_buffer, ensure_ascii);
+        return _buffer;
+    }
+
+    size_t capacity() const noexcept { return _buffer.capacity(); }
+
+    // Gives back memory after an unusually large message
+    void shrink_to_fit()
+    {
+        _buffer.clear();
+        _buffer.shrink_to_fit();
+    }
+
+    // Per-thread instance for call sites that do not want to carry a serializer around
+    static serializer& thread_local_instance()
+    {
+        thread_local serializer instance;
+        return instance;
+    }
+
+private:
+    std::string _buffer;
+};
+} // namespace json
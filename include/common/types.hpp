@@ -4,4 +4,9 @@
 
 #include "array.hpp"
 #include "object.hpp"
+#include "persistent_value.hpp"
+#include "serializer.hpp"
 #include "value.hpp"
+
+// needs the complete value, array and object
+#include "frozen_value.hpp"
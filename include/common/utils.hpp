@@ -2,10 +2,16 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <charconv>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <iomanip>
 #include <limits>
+#include <locale>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <string_view>
@@ -13,11 +19,62 @@
 #include <utility>
 #include <variant>
 
+#include "../parser/packed_bytes.hpp"
+
 namespace json
 {
 class value;
 class array;
 class object;
+
+struct format_options
+{
+    // number of indent_char per nesting level
+    size_t indent = 4;
+    // usually ' ' or '\t'
+    char indent_char = ' ';
+    // print arrays that only contain scalars on a single line
+    bool compact_arrays = false;
+    // escape all non-ASCII characters as \uXXXX
+    bool ensure_ascii = false;
+};
+
+// Heap owned by a json::value tree, see value::memory_usage().
+// Sizes are estimates from capacities and node layouts; allocator bookkeeping is not included.
+struct memory_stats
+{
+    // out-of-line buffers of strings, numbers and object keys, including their unused capacity
+    size_t strings = 0;
+    // element buffers of arrays, including slack
+    size_t array_buffers = 0;
+    // the part of array_buffers past the elements
+    size_t array_slack = 0;
+    // std::map nodes of object members
+    size_t object_nodes = 0;
+    // array and object nodes with their shared_ptr control blocks
+    size_t containers = 0;
+
+    // values of each type; a node shared by snapshots is counted once
+    size_t nulls = 0;
+    size_t booleans = 0;
+    size_t numbers = 0;
+    size_t string_values = 0;
+    size_t arrays = 0;
+    size_t objects = 0;
+
+    size_t total() const noexcept { return strings + array_buffers + object_nodes + containers; }
+};
+
+// How value::merge() combines two arrays at the same place
+enum class array_merge
+{
+    // rhs replaces the array, like any other non-object value
+    replace,
+    // rhs elements are appended
+    concat,
+    // elements at the same index are merged, extra rhs elements are appended
+    by_index,
+};
 }
 
 namespace json::ext
@@ -30,6 +87,17 @@ public:
     // bool check_json(const value&) const;
     // bool from_json(const value&, T&) const;
 };
+
+// Opt-in tagged deserialization for a std::variant: the alternative is picked from the json before converting,
+// instead of trying every alternative in turn. Specialize with either
+//     static constexpr std::string_view key = "type";
+//     static constexpr std::string_view tags[] = { "circle", "rect" };  // one per alternative, in order
+// or
+//     size_t index(const value&) const;  // the alternative to convert to, std::variant_npos if none
+template <typename T, typename = void>
+class variant_tag
+{
+};
 }
 
 namespace json::_utils
@@ -86,11 +154,41 @@ constexpr bool is_nullable<
 template <typename T, typename = std::enable_if_t<is_nullable<T>>>
 using nullable_value_t = std::decay_t<decltype(*std::declval<T>())>;
 
+template <typename T>
+constexpr bool is_std_optional = false;
+template <typename T>
+constexpr bool is_std_optional<std::optional<T>> = true;
+
 template <typename T>
 constexpr bool is_variant = false;
 template <typename... args_t>
 constexpr bool is_variant<std::variant<args_t...>> = true;
 
+template <typename T, typename = void>
+struct has_variant_tag_key : std::false_type
+{
+};
+
+template <typename T>
+struct has_variant_tag_key<T, std::void_t<decltype(ext::variant_tag<T>::key), decltype(ext::variant_tag<T>::tags)>>
+    : std::true_type
+{
+};
+
+template <typename T, typename = void>
+struct has_variant_tag_index : std::false_type
+{
+};
+
+template <typename T>
+struct has_variant_tag_index<T, std::void_t<decltype(std::declval<ext::variant_tag<T>>().index(std::declval<value>()))>>
+    : std::true_type
+{
+};
+
+template <typename T>
+constexpr bool is_tagged_variant = is_variant<T> && (has_variant_tag_key<T>::value || has_variant_tag_index<T>::value);
+
 template <typename T>
 constexpr bool is_tuple = false;
 template <typename... args_t>
@@ -180,6 +278,17 @@ struct has_to_json_in_member<T, std::void_t<decltype(std::declval<T>().to_json()
 {
 };
 
+template <typename T, typename = void>
+struct has_dump_json_in_member : std::false_type
+{
+};
+
+template <typename T>
+struct has_dump_json_in_member<T, std::void_t<decltype(std::declval<const T&>().dump_json_to(std::declval<std::string&>()))>>
+    : std::true_type
+{
+};
+
 template <typename T, typename = void>
 struct has_check_json_in_member : std::false_type
 {
@@ -211,6 +320,19 @@ struct has_to_json_in_templ_spec<T, std::void_t<decltype(std::declval<ext::jsoni
 {
 };
 
+template <typename T, typename = void>
+struct has_dump_json_in_templ_spec : std::false_type
+{
+};
+
+template <typename T>
+struct has_dump_json_in_templ_spec<
+    T,
+    std::void_t<decltype(std::declval<ext::jsonization<std::decay_t<T>>>().dump_json_to(std::declval<T>(), std::declval<std::string&>()))>>
+    : std::true_type
+{
+};
+
 template <typename T, typename = void>
 struct has_check_json_in_templ_spec : std::false_type
 {
@@ -391,14 +513,94 @@ inline char hex_digit(unsigned char value) noexcept
     return static_cast<char>(value < 10 ? ('0' + value) : ('a' + value - 10));
 }
 
-inline void append_escaped_string(std::string& result, std::string_view str)
+template <typename out_t>
+inline void append_unicode_escape(out_t& result, uint32_t code_unit)
 {
-    auto cur = str.cbegin();
-    auto end = str.cend();
-    auto no_escape_beg = cur;
+    result.append("\\u", 2);
+    result.push_back(hex_digit(static_cast<unsigned char>((code_unit >> 12) & 0x0F)));
+    result.push_back(hex_digit(static_cast<unsigned char>((code_unit >> 8) & 0x0F)));
+    result.push_back(hex_digit(static_cast<unsigned char>((code_unit >> 4) & 0x0F)));
+    result.push_back(hex_digit(static_cast<unsigned char>(code_unit & 0x0F)));
+}
+
+// Decodes the UTF-8 sequence at cur, advancing cur past it. Invalid sequences yield U+FFFD and consume one byte.
+inline uint32_t decode_utf8(const char*& cur, const char* end) noexcept
+{
+    const auto lead = static_cast<unsigned char>(*cur);
+    size_t len = 0;
+    uint32_t cp = 0;
+    uint32_t min_cp = 0;
+    if (lead >= 0xF0 && lead <= 0xF4) {
+        len = 4;
+        cp = lead & 0x07;
+        min_cp = 0x10000;
+    }
+    else if (lead >= 0xE0) {
+        len = 3;
+        cp = lead & 0x0F;
+        min_cp = 0x800;
+    }
+    else if (lead >= 0xC2 && lead <= 0xDF) {
+        len = 2;
+        cp = lead & 0x1F;
+        min_cp = 0x80;
+    }
+    if (len == 0 || lead > 0xF4 || static_cast<size_t>(end - cur) < len) {
+        ++cur;
+        return 0xFFFD;
+    }
+    for (size_t i = 1; i < len; ++i) {
+        const auto ch = static_cast<unsigned char>(cur[i]);
+        if ((ch & 0xC0) != 0x80) {
+            ++cur;
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (ch & 0x3F);
+    }
+    if (cp < min_cp || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        ++cur;
+        return 0xFFFD;
+    }
+    cur += len;
+    return cp;
+}
+
+// out_t is std::string or any writer providing append(const char*, size_t) and push_back(char).
+// With ensure_ascii, non-ASCII characters are written as \uXXXX escapes (surrogate pairs above U+FFFF).
+template <bool ensure_ascii = false, typename out_t>
+inline void append_escaped_string(out_t& result, std::string_view str)
+{
+    using accel_traits = _packed_bytes::packed_bytes_trait_max;
+
+    const char* cur = str.data();
+    const char* end = cur + str.size();
+    const char* no_escape_beg = cur;
     char escape = 0;
 
-    for (; cur != end; ++cur) {
+    while (cur != end) {
+        if constexpr (accel_traits::available) {
+            // skip whole blocks that need no escaping
+            while (end - cur >= accel_traits::step) {
+                auto pack = accel_traits::load_unaligned(cur);
+                auto mask = accel_traits::less(pack, 0x20);
+                mask = accel_traits::bitwise_or(mask, accel_traits::equal(pack, static_cast<uint8_t>('"')));
+                mask = accel_traits::bitwise_or(mask, accel_traits::equal(pack, static_cast<uint8_t>('\\')));
+                if constexpr (ensure_ascii) {
+                    mask = accel_traits::bitwise_or(mask, accel_traits::non_ascii(pack));
+                }
+                if (accel_traits::is_all_zero(mask)) {
+                    cur += accel_traits::step;
+                }
+                else {
+                    cur += accel_traits::first_nonzero_byte(mask);
+                    break;
+                }
+            }
+            if (cur == end) {
+                break;
+            }
+        }
+
         const auto ch = static_cast<unsigned char>(*cur);
         switch (ch) {
         case '"':
@@ -426,23 +628,103 @@ inline void append_escaped_string(std::string& result, std::string_view str)
             break;
         }
         if (escape) {
-            result.append(no_escape_beg, cur);
+            result.append(no_escape_beg, static_cast<size_t>(cur - no_escape_beg));
             result.push_back('\\');
             result.push_back(escape);
-            no_escape_beg = cur + 1;
+            no_escape_beg = ++cur;
             escape = 0;
         }
         else if (ch < 0x20) {
-            result.append(no_escape_beg, cur);
-            result += "\\u00";
-            result.push_back(hex_digit(static_cast<unsigned char>(ch >> 4)));
-            result.push_back(hex_digit(static_cast<unsigned char>(ch & 0x0F)));
-            no_escape_beg = cur + 1;
+            result.append(no_escape_beg, static_cast<size_t>(cur - no_escape_beg));
+            append_unicode_escape(result, ch);
+            no_escape_beg = ++cur;
         }
+        else if (ensure_ascii && ch >= 0x80) {
+            result.append(no_escape_beg, static_cast<size_t>(cur - no_escape_beg));
+            const uint32_t cp = decode_utf8(cur, end);
+            if (cp >= 0x10000) {
+                append_unicode_escape(result, 0xD800 + ((cp - 0x10000) >> 10));
+                append_unicode_escape(result, 0xDC00 + ((cp - 0x10000) & 0x3FF));
+            }
+            else {
+                append_unicode_escape(result, cp);
+            }
+            no_escape_beg = cur;
+        }
+        else {
+            ++cur;
+        }
+    }
+    result.append(no_escape_beg, static_cast<size_t>(cur - no_escape_beg));
+}
+
+// Structural hash of an array or object node, filled by value::hash(); 0 means not computed.
+// Relaxed atomics keep concurrent hashing of a shared const document race free.
+class hash_cache
+{
+public:
+    hash_cache() = default;
+
+    // A copied or moved node starts uncached: it is usually about to be modified through array or
+    // object, which know nothing of the value that cached the hash
+    hash_cache(const hash_cache&) noexcept {}
+
+    hash_cache(hash_cache&& rhs) noexcept { rhs.reset(); }
+
+    hash_cache& operator=(const hash_cache&) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    hash_cache& operator=(hash_cache&& rhs) noexcept
+    {
+        reset();
+        rhs.reset();
+        return *this;
     }
-    result.append(no_escape_beg, cur);
+
+    size_t get() const noexcept { return _hash.load(std::memory_order_relaxed); }
+
+    void set(size_t hash) const noexcept { _hash.store(hash, std::memory_order_relaxed); }
+
+    void reset() noexcept { set(0); }
+
+private:
+    mutable std::atomic<size_t> _hash { 0 };
+};
+
+inline size_t hash_combine(size_t seed, size_t hash) noexcept
+{
+    return seed ^ (hash + static_cast<size_t>(0x9e3779b97f4a7c15ULL) + (seed << 6) + (seed >> 2));
 }
 
+// Precomputed "\n + indentation" buffer, so that each line of formatted output costs a single append.
+class indent_cache
+{
+public:
+    explicit indent_cache(const format_options& options)
+        : _options(options)
+    {
+    }
+
+    const format_options& options() const noexcept { return _options; }
+
+    void newline(std::string& out, size_t indent_times)
+    {
+        const size_t len = 1 + _options.indent * indent_times;
+        if (_buffer.size() < len) {
+            _buffer.assign(std::max(len, _buffer.size() * 2), _options.indent_char);
+            _buffer.front() = '\n';
+        }
+        out.append(_buffer.data(), len);
+    }
+
+private:
+    format_options _options;
+    std::string _buffer;
+};
+
 inline std::string escape_string(std::string_view str)
 {
     std::string result;
@@ -458,6 +740,236 @@ inline std::string unescape_string(const std::string& str)
     return escape_string(str);
 }
 
+// Buffers small writes and hands them in chunks to a callable taking std::string_view, e.g. a hash update
+template <typename func_t>
+class callback_writer
+{
+public:
+    explicit callback_writer(func_t& func) noexcept
+        : _func(func)
+    {
+    }
+
+    void append(const char* data, size_t len)
+    {
+        if (len > sizeof(_buffer) - _size) {
+            flush();
+            if (len >= sizeof(_buffer)) {
+                _func(std::string_view(data, len));
+                return;
+            }
+        }
+        std::copy_n(data, len, _buffer + _size);
+        _size += len;
+    }
+
+    void push_back(char ch)
+    {
+        if (_size == sizeof(_buffer)) {
+            flush();
+        }
+        _buffer[_size++] = ch;
+    }
+
+    void flush()
+    {
+        if (_size) {
+            _func(std::string_view(_buffer, _size));
+            _size = 0;
+        }
+    }
+
+private:
+    func_t& _func;
+    size_t _size = 0;
+    char _buffer[4096];
+};
+
+// Integers up to 15 digits print identically in ECMAScript, so they can skip the double round trip
+inline bool is_canonical_integer(std::string_view num) noexcept
+{
+    const bool negative = !num.empty() && num.front() == '-';
+    if (negative) {
+        num.remove_prefix(1);
+    }
+    if (num.empty() || num.size() > 15 || (num.front() == '0' && (num.size() != 1 || negative))) {
+        return false;
+    }
+    return std::all_of(num.begin(), num.end(), [](char ch) { return ch >= '0' && ch <= '9'; });
+}
+
+// For a json number out of the range of double: whether it is below 1 in magnitude, i.e. it underflowed
+// rather than overflowed. Compares the order of the first significant digit with the exponent.
+inline bool is_underflow_number(std::string_view num) noexcept
+{
+    size_t pos = !num.empty() && num.front() == '-' ? 1 : 0;
+    long long order = 0;
+    bool significant = false;
+    for (; pos < num.size() && num[pos] >= '0' && num[pos] <= '9'; ++pos) {
+        significant = significant || num[pos] != '0';
+        order += significant ? 1 : 0;
+    }
+    if (pos < num.size() && num[pos] == '.') {
+        for (++pos; pos < num.size() && num[pos] >= '0' && num[pos] <= '9'; ++pos) {
+            if (significant) {
+                continue;
+            }
+            significant = num[pos] != '0';
+            order -= significant ? 0 : 1;
+        }
+    }
+    if (!significant) {
+        return false;
+    }
+
+    long long exp = 0;
+    if (pos < num.size() && (num[pos] == 'e' || num[pos] == 'E')) {
+        const bool negative = ++pos < num.size() && num[pos] == '-';
+        pos += pos < num.size() && (num[pos] == '-' || num[pos] == '+') ? 1 : 0;
+        // saturated far beyond any double exponent
+        for (; pos < num.size() && num[pos] >= '0' && num[pos] <= '9' && exp < 1'000'000'000; ++pos) {
+            exp = exp * 10 + (num[pos] - '0');
+        }
+        exp = negative ? -exp : exp;
+    }
+    // the value is in [10^(order - 1), 10^order) times 10^exp
+    return order + exp <= 0;
+}
+
+// Whole json number as a double, independent of the C locale (unlike strtod). Subnormals are kept and
+// an underflow becomes 0 as in ECMAScript; returns false for other text and for an overflow.
+inline bool parse_double(std::string_view num, double& result)
+{
+    const double zero = !num.empty() && num.front() == '-' ? -0.0 : 0.0;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    const auto [ptr, ec] = std::from_chars(num.data(), num.data() + num.size(), result);
+    if (ptr != num.data() + num.size()) {
+        return false;
+    }
+    if (ec == std::errc::result_out_of_range && is_underflow_number(num)) {
+        result = zero;
+        return true;
+    }
+    return ec == std::errc {} && std::isfinite(result);
+#else
+    // floating point std::from_chars is missing from older standard libraries, e.g. libc++ before 20
+    std::istringstream in { std::string(num) };
+    in.imbue(std::locale::classic());
+    in >> result;
+    if (num.empty() || !in.eof()) {
+        return false;
+    }
+    if (in.fail()) {
+        // a range error; some libraries report subnormals as one too, and keep them in result
+        if (!is_underflow_number(num)) {
+            return false;
+        }
+        result = std::abs(result) < std::numeric_limits<double>::min() ? result : zero;
+    }
+    return std::isfinite(result);
+#endif
+}
+
+// Number::toString of ECMAScript, as required by RFC 8785. Returns false for NaN and infinity.
+template <typename out_t>
+inline bool append_ecmascript_number(out_t& out, double num)
+{
+    static constexpr std::string_view zeros = "000000000000000000000";
+
+    if (!std::isfinite(num)) {
+        return false;
+    }
+    if (num == 0) {
+        out.push_back('0');
+        return true;
+    }
+
+    // shortest round-trip representation: [-]d[.ddd]e(+|-)xx
+    char buf[32];
+    const auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), num, std::chars_format::scientific);
+    if (ec != std::errc {}) {
+        return false;
+    }
+
+    const char* cur = buf;
+    if (*cur == '-') {
+        out.push_back('-');
+        ++cur;
+    }
+    char digits[20];
+    int k = 0;
+    for (; *cur != 'e'; ++cur) {
+        if (*cur != '.') {
+            digits[k++] = *cur;
+        }
+    }
+    if (*++cur == '+') {
+        ++cur;
+    }
+    int exp = 0;
+    std::from_chars(cur, ptr, exp);
+
+    const int n = exp + 1;
+    if (k <= n && n <= 21) {
+        out.append(digits, static_cast<size_t>(k));
+        out.append(zeros.data(), static_cast<size_t>(n - k));
+    }
+    else if (0 < n && n <= 21) {
+        out.append(digits, static_cast<size_t>(n));
+        out.push_back('.');
+        out.append(digits + n, static_cast<size_t>(k - n));
+    }
+    else if (-6 < n && n <= 0) {
+        out.append("0.", 2);
+        out.append(zeros.data(), static_cast<size_t>(-n));
+        out.append(digits, static_cast<size_t>(k));
+    }
+    else {
+        out.push_back(digits[0]);
+        if (k > 1) {
+            out.push_back('.');
+            out.append(digits + 1, static_cast<size_t>(k - 1));
+        }
+        out.push_back('e');
+        out.push_back(n - 1 < 0 ? '-' : '+');
+        char exp_buf[8];
+        const auto exp_end = std::to_chars(exp_buf, exp_buf + sizeof(exp_buf), n - 1 < 0 ? 1 - n : n - 1).ptr;
+        out.append(exp_buf, static_cast<size_t>(exp_end - exp_buf));
+    }
+    return true;
+}
+
+// UTF-8 byte order equals code point order, which only differs from UTF-16 code unit order
+// when a supplementary character (lead byte 0xF0+) is compared with U+E000..U+FFFF.
+inline bool has_supplementary_char(std::string_view str) noexcept
+{
+    return std::any_of(str.begin(), str.end(), [](char ch) { return static_cast<unsigned char>(ch) >= 0xF0; });
+}
+
+inline bool utf16_less(std::string_view lhs, std::string_view rhs) noexcept
+{
+    const auto [lhs_iter, rhs_iter] = std::mismatch(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    if (lhs_iter == lhs.end() || rhs_iter == rhs.end()) {
+        return lhs.size() < rhs.size();
+    }
+
+    size_t lead = static_cast<size_t>(lhs_iter - lhs.begin());
+    while (lead > 0 && (static_cast<unsigned char>(lhs[lead]) & 0xC0) == 0x80) {
+        --lead;
+    }
+    // surrogate pairs (0xD800..0xDBFF) sort between U+D7FF (lead 0xED) and U+E000 (lead 0xEE)
+    auto weight = [](char ch) {
+        const auto lead_byte = static_cast<unsigned char>(ch);
+        return lead_byte >= 0xF0 ? 0xED * 2 + 1 : lead_byte * 2;
+    };
+    const int lhs_weight = weight(lhs[lead]);
+    const int rhs_weight = weight(rhs[lead]);
+    if (lhs_weight != rhs_weight) {
+        return lhs_weight < rhs_weight;
+    }
+    return static_cast<unsigned char>(*lhs_iter) < static_cast<unsigned char>(*rhs_iter);
+}
+
 inline std::string_view true_string()
 {
     return "true";
@@ -489,4 +1001,71 @@ inline std::string to_basic_string(any_t&& arg)
         return std::to_string(std::forward<any_t>(arg));
     }
 }
+
+// Path of the last failed conversion on this thread. It is only written while a failure unwinds:
+// the value that did not fit records itself and each container prefixes its own segment, so
+// successful conversions never touch it, and a trail nobody took is overwritten by the next failure.
+struct conversion_trail
+{
+    // the json value the path is relative to
+    const void* source = nullptr;
+    std::string path;
+    std::string reason;
+};
+
+inline conversion_trail& failed_conversion() noexcept
+{
+    thread_local conversion_trail trail;
+    return trail;
+}
+
+// Converting child, the member or element segment of source, has failed.
+// If the child left no trail, or only recorded that it did not fit, it is the innermost failure and
+// leaf_reason() describes it.
+template <typename reason_func_t>
+inline void prepend_failure(const void* source, const void* child, std::string_view segment, reason_func_t&& leaf_reason)
+{
+    auto& trail = failed_conversion();
+    if (trail.source != child || !child) {
+        trail.path.clear();
+        trail.reason.clear();
+    }
+    if (trail.reason.empty()) {
+        trail.reason = leaf_reason();
+    }
+
+    // JSON pointer escaping
+    std::string escaped = "/";
+    for (char c : segment) {
+        if (c == '~') {
+            escaped.append("~0");
+        }
+        else if (c == '/') {
+            escaped.append("~1");
+        }
+        else {
+            escaped.push_back(c);
+        }
+    }
+    trail.path.insert(0, escaped);
+    trail.source = source;
+}
+
+// source itself did not fit, e.g. a type mismatch; the reason is described when the failure is taken
+inline void set_failure(const void* source) noexcept
+{
+    auto& trail = failed_conversion();
+    trail.source = source;
+    trail.path.clear();
+    trail.reason.clear();
+}
+
+// Conversion of source failed as a whole, e.g. no variant alternative matched
+inline void set_failure(const void* source, std::string reason)
+{
+    auto& trail = failed_conversion();
+    trail.source = source;
+    trail.path.clear();
+    trail.reason = std::move(reason);
+}
 } // namespace json::_utils
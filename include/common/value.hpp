@@ -2,14 +2,18 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdlib>
 #include <initializer_list>
 #include <memory>
+#include <new>
 #include <optional>
 #include <ostream>
 #include <string>
 #include <tuple>
 #include <type_traits>
+#include <unordered_set>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -20,14 +24,16 @@
 
 #include "enum_reflection.hpp"
 #include "exception.hpp"
+#include "segment_buffer.hpp"
 #include "utils.hpp"
 
 namespace json
 {
 class value
 {
-    using array_ptr = std::unique_ptr<array>;
-    using object_ptr = std::unique_ptr<object>;
+    // Shared only between snapshot() copies, see there
+    using array_ptr = std::shared_ptr<array>;
+    using object_ptr = std::shared_ptr<object>;
 
 public:
     enum class value_type : char
@@ -50,6 +56,12 @@ public:
     value(const value& rhs);
     value(value&& rhs) noexcept;
 
+    // O(1) copy sharing every array and object with this value. A shared node is cloned (one level,
+    // children stay shared) on the first non-const access from either side, so both behave as deep copies.
+    // Copies of a snapshot are deep again; references obtained from the non-const accessors before
+    // taking a snapshot must not be used to modify it afterwards.
+    value snapshot() const;
+
     value(bool b);
 
     value(int num);
@@ -176,7 +188,7 @@ public:
             bool> = true>
     value(const arr_t<value_t, size>& arr)
         : _type(value_type::array)
-        , _raw_data(std::make_unique<array>(arr))
+        , _raw_data(std::make_shared<array>(arr))
     {
     }
 
@@ -191,7 +203,7 @@ public:
             bool> = true>
     value(arr_t<value_t, size>&& arr)
         : _type(value_type::array)
-        , _raw_data(std::make_unique<array>(std::move(arr)))
+        , _raw_data(std::make_shared<array>(std::move(arr)))
     {
     }
 
@@ -205,7 +217,7 @@ public:
             bool> = true>
     value(const collection_t& coll)
         : _type(value_type::array)
-        , _raw_data(std::make_unique<array>(coll))
+        , _raw_data(std::make_shared<array>(coll))
     {
     }
 
@@ -218,7 +230,7 @@ public:
             bool> = true>
     value(collection_t&& coll)
         : _type(value_type::array)
-        , _raw_data(std::make_unique<array>(std::move(coll)))
+        , _raw_data(std::make_shared<array>(std::move(coll)))
     {
     }
 
@@ -233,7 +245,7 @@ public:
             bool> = true>
     value(const tuple_t<args_t...>& tpl)
         : _type(value_type::array)
-        , _raw_data(std::make_unique<array>(tpl))
+        , _raw_data(std::make_shared<array>(tpl))
     {
     }
 
@@ -247,7 +259,7 @@ public:
             bool> = true>
     value(tuple_t<args_t...>&& tpl)
         : _type(value_type::array)
-        , _raw_data(std::make_unique<array>(std::move(tpl)))
+        , _raw_data(std::make_shared<array>(std::move(tpl)))
     {
     }
 
@@ -261,7 +273,7 @@ public:
             bool> = true>
     value(const map_t& m)
         : _type(value_type::object)
-        , _raw_data(std::make_unique<object>(m))
+        , _raw_data(std::make_shared<object>(m))
     {
     }
 
@@ -274,7 +286,7 @@ public:
             bool> = true>
     value(map_t&& m)
         : _type(value_type::object)
-        , _raw_data(std::make_unique<object>(std::move(m)))
+        , _raw_data(std::make_shared<object>(std::move(m)))
     {
     }
 
@@ -383,6 +395,18 @@ public:
     template <typename value_t>
     value_t as() &&;
 
+    // Checks and converts in a single pass, std::nullopt where is<value_t>() would be false
+    template <typename value_t>
+    std::optional<value_t> try_as() const&;
+
+    // Moves strings and containers out; the value is left unspecified if std::nullopt is returned
+    template <typename value_t>
+    std::optional<value_t> try_as() &&;
+
+    // Same as try_as(), and on failure tells where: error.path is a JSON pointer such as /items/17/price
+    template <typename value_t>
+    std::optional<value_t> try_as(conversion_error& error) const&;
+
     array& as_array();
     object& as_object();
 
@@ -402,15 +426,39 @@ private:
     template <typename... Ts>
     std::variant<Ts...> move_to_variant_helper() &&;
 
+    template <typename... Ts>
+    std::optional<std::variant<Ts...>> try_variant_helper(std::variant<Ts...>*) const;
+
+    // alternative selected by ext::variant_tag, std::variant_npos if none
+    template <typename variant_t>
+    size_t variant_tag_index() const;
+
+    // the failure recorded for this value by the last conversion, consuming it
+    conversion_error take_failure() const;
+    std::string failure_info() const;
+
 public:
     void clear() noexcept;
 
-    std::string dumps(std::optional<size_t> indent = std::nullopt) const;
+    std::string dumps(std::optional<size_t> indent = std::nullopt, bool ensure_ascii = false) const;
 
     // return raw string
     std::string to_string() const;
+    // Appends the compact form to out, reusing its capacity; see also json::serializer
+    void dump_to(std::string& out, bool ensure_ascii = false) const;
 
     std::string format(size_t indent = 4) const;
+    std::string format(const format_options& options) const;
+
+    // RFC 8785 JSON Canonicalization Scheme, for hashing and signing
+    std::string dumps_canonical() const;
+    void dump_canonical_to(std::string& out) const;
+    // sink is called with std::string_view chunks, e.g. a hash update, so the output is never materialized
+    template <typename sink_t, std::enable_if_t<std::is_invocable_v<sink_t&, std::string_view>, bool> = true>
+    void dump_canonical_to(sink_t&& sink) const;
+
+    // Appends the compact form as segments referencing this value's string storage, see segment_buffer
+    void dump_segments_to(segment_buffer& out) const;
 
     value& operator=(const value& rhs);
     value& operator=(value&&) noexcept;
@@ -423,6 +471,22 @@ public:
     //     return *this = value(std::move(rhs));
     // }
 
+    // Heap occupied by this tree, by category and with per-type counts. One pass that only allocates its
+    // walk stack and a set of the nodes shared with snapshots, so it can be sampled in production.
+    memory_stats memory_usage() const;
+
+    // Trims the spare capacity of arrays, strings and object keys, e.g. for documents kept in a cache
+    // after parsing. Nodes shared with snapshots are left alone. Returns the bytes given back, as
+    // counted by memory_usage().
+    size_t compact();
+
+    // Structural hash consistent with operator==, also available as std::hash<json::value>.
+    // Arrays and objects cache their hash until they are modified or reached through a non-const accessor.
+    // Modifying a nested node through a reference obtained before hashing does not reach the caches of
+    // its parents, so such references must not be used to modify the value afterwards.
+    // operator== never reads the caches and stays exact either way.
+    size_t hash() const;
+
     bool operator==(const value& rhs) const;
 
     bool operator!=(const value& rhs) const;
@@ -448,6 +512,13 @@ public:
     value& operator+=(const array& rhs);
     value& operator+=(array&& rhs);
 
+    // Deep merge: objects on both sides are merged member by member, arrays as requested, and anything
+    // else in rhs replaces what is here. The rvalue overload moves out of rhs and splices the map nodes
+    // of members missing here instead of copying them, e.g. for layering defaults | env | overrides.
+    // rhs may be this value or part of it; merging a moved-from part leaves that part moved-from.
+    value& merge(const value& rhs, array_merge arrays = array_merge::replace);
+    value& merge(value&& rhs, array_merge arrays = array_merge::replace);
+
     explicit operator bool() const;
 
     explicit operator int() const;
@@ -509,6 +580,16 @@ public:
         return dst;
     }
 
+    template <typename jsonization_t, std::enable_if_t<_utils::has_from_json_in_member<jsonization_t>::value, bool> = true>
+    explicit operator jsonization_t() &&
+    {
+        jsonization_t dst {};
+        if (!dst.from_json(std::move(*this))) {
+            throw exception("Deserialization failed: from_json() returned false, " + value_info());
+        }
+        return dst;
+    }
+
     template <
         typename jsonization_t,
         std::enable_if_t<_utils::has_from_json_in_templ_spec<std::decay_t<jsonization_t>>::value, bool> = true>
@@ -650,12 +731,63 @@ public:
 private:
     friend class array;
     friend class object;
-
-    void dump_to(std::string& out) const;
-    void format_to(std::string& out, size_t indent, size_t indent_times) const;
-    std::string format(size_t indent, size_t indent_times) const;
+    // reads number and string text without copying
+    friend class frozen_value;
+
+    template <bool ensure_ascii = false, typename writer_t>
+    void write_compact(writer_t& out) const;
+    template <bool ensure_ascii, typename writer_t>
+    void write_scalar(writer_t& out) const;
+    // Nested arrays and objects are walked with an explicit stack by the writers, copy, comparison
+    // and destructor, so deeply nested documents cannot overflow the call stack.
+    // Exactly one of arr and obj is the root. visitor_t writes the brackets, separators, keys and scalars
+    // it is handed, see write_compact_tree().
+    template <typename visitor_t>
+    static void walk_tree(visitor_t& visitor, const array* arr, const object* obj);
+    template <bool ensure_ascii, typename writer_t>
+    static void write_compact_tree(writer_t& out, const array* arr, const object* obj);
+    static void format_tree(std::string& out, _utils::indent_cache& indent, const array* arr, const object* obj, size_t indent_times);
+    static size_t format_size_tree(const format_options& options, const array* arr, const object* obj, size_t indent_times);
+    template <typename writer_t>
+    static void write_canonical_tree(writer_t& out, const array* arr, const object* obj);
+    void format_to(std::string& out, _utils::indent_cache& indent, size_t indent_times) const;
+    size_t format_size(const format_options& options, size_t indent_times) const;
+    template <typename writer_t>
+    void write_canonical(writer_t& out) const;
+    template <typename writer_t>
+    void write_canonical_scalar(writer_t& out) const;
 
     static var_t deep_copy(const var_t& src);
+    // Nesting copied by the containers' own copy constructors, which clone a std::map without comparing
+    // keys; nodes deeper than that are copied with an explicit stack
+    static constexpr size_t recursive_copy_depth = 64;
+    static size_t& copy_depth() noexcept;
+    template <typename src_t>
+    static void merge_tree(value& dst, src_t& src, array_merge arrays);
+
+    // heap bytes of a std::string, 0 while it fits in the small string buffer
+    static size_t string_heap(const std::string& str) noexcept;
+
+    // nullptr for scalars
+    const _utils::hash_cache* node_hash() const noexcept;
+    size_t scalar_hash() const;
+    // compares everything but the contents of nested arrays and objects, which are queued in pending
+    static bool equal_shallow(
+        const value& lhs,
+        const value& rhs,
+        std::vector<std::pair<const value*, const value*>>& pending);
+    // Sole owner of node, with an acquire fence that pairs with the release in the last other owner's
+    // reference drop, so its reads of the node happen before the caller writes to it in place
+    template <typename node_t>
+    static bool exclusive(const std::shared_ptr<node_t>& node) noexcept;
+    // whether this value is the only owner of its array or object node
+    bool owns_node() const noexcept;
+    // whether destroying this value would recurse into nested arrays or objects
+    bool owns_nested() const noexcept;
+    // moves the nested arrays and objects that would be destroyed with this value into pending
+    void release_nested(std::vector<value>& pending);
+    // clones the array or object node if it is shared with a snapshot
+    void detach();
 
     template <typename... key_then_default_value_t, size_t... keys_indexes_t>
     auto get(std::tuple<key_then_default_value_t...> keys_then_default_value, std::index_sequence<keys_indexes_t...>) const;
@@ -672,3 +804,12 @@ private:
     var_t _raw_data;
 };
 } // namespace json
+
+namespace std
+{
+template <>
+struct hash<json::value>
+{
+    size_t operator()(const json::value& val) const { return val.hash(); }
+};
+} // namespace std
@@ -28,11 +28,10 @@ inline value_t parse_integer(const std::string& str, const char* target_type)
 }
 
 template <typename value_t>
-inline value_t parse_floating(const std::string& str, const char* target_type)
+inline bool try_parse_floating(const std::string& str, value_t& result) noexcept
 {
     try {
         size_t pos = 0;
-        value_t result {};
         if constexpr (std::is_same_v<value_t, float>) {
             result = std::stof(str, &pos);
         }
@@ -42,12 +41,19 @@ inline value_t parse_floating(const std::string& str, const char* target_type)
         else {
             result = std::stold(str, &pos);
         }
-
-        if (pos == str.size()) {
-            return result;
-        }
+        return pos == str.size();
     }
     catch (const std::exception&) {
+        return false;
+    }
+}
+
+template <typename value_t>
+inline value_t parse_floating(const std::string& str, const char* target_type)
+{
+    value_t result {};
+    if (try_parse_floating(str, result)) {
+        return result;
     }
 
     throw exception("Parse error: cannot convert number '" + str + "' to " + target_type);
@@ -56,22 +62,24 @@ inline value_t parse_floating(const std::string& str, const char* target_type)
 template <typename value_t>
 inline bool can_parse_floating(const std::string& str) noexcept
 {
-    try {
-        size_t pos = 0;
-        if constexpr (std::is_same_v<value_t, float>) {
-            (void)std::stof(str, &pos);
-        }
-        else if constexpr (std::is_same_v<value_t, double>) {
-            (void)std::stod(str, &pos);
-        }
-        else {
-            (void)std::stold(str, &pos);
-        }
-        return pos == str.size();
-    }
-    catch (const std::exception&) {
-        return false;
-    }
+    value_t result {};
+    return try_parse_floating(str, result);
+}
+
+// Calls func(std::integral_constant<size_t, I>) for the alternative I == index, false for std::variant_npos
+template <typename variant_t, typename func_t, size_t... Is>
+inline bool visit_alternative(size_t index, func_t&& func, std::index_sequence<Is...>)
+{
+    return ((index == Is ? func(std::integral_constant<size_t, Is> {}) : false) || ...);
+}
+
+template <typename variant_t, typename func_t>
+inline bool visit_alternative(size_t index, func_t&& func)
+{
+    return visit_alternative<variant_t>(
+        index,
+        std::forward<func_t>(func),
+        std::make_index_sequence<std::variant_size_v<variant_t>> {});
 }
 } // namespace _value_impl_detail
 
@@ -85,6 +93,46 @@ inline value::value(const value& rhs)
 
 inline value::value(value&& rhs) noexcept = default;
 
+inline value value::snapshot() const
+{
+    value result;
+    result._type = _type;
+    result._raw_data = _raw_data;
+    return result;
+}
+
+template <typename node_t>
+inline bool value::exclusive(const std::shared_ptr<node_t>& node) noexcept
+{
+    // use_count() is a relaxed load
+    if (node.use_count() != 1) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+}
+
+inline void value::detach()
+{
+    if (auto arr_ptr = std::get_if<array_ptr>(&_raw_data); arr_ptr && *arr_ptr && !exclusive(*arr_ptr)) {
+        const auto& src = (*arr_ptr)->_array_data;
+        auto dst = std::make_shared<array>();
+        dst->_array_data.reserve(src.size());
+        for (const auto& elem : src) {
+            dst->_array_data.emplace_back(elem.snapshot());
+        }
+        *arr_ptr = std::move(dst);
+    }
+    else if (auto obj_ptr = std::get_if<object_ptr>(&_raw_data); obj_ptr && *obj_ptr && !exclusive(*obj_ptr)) {
+        const auto& src = (*obj_ptr)->_object_data;
+        auto dst = std::make_shared<object>();
+        for (const auto& [key, elem] : src) {
+            dst->_object_data.emplace_hint(dst->_object_data.end(), key, elem.snapshot());
+        }
+        *obj_ptr = std::move(dst);
+    }
+}
+
 inline value::value(bool b)
     : _type(value_type::boolean)
     , _raw_data(b ? std::string(_utils::true_string()) : std::string(_utils::false_string()))
@@ -175,35 +223,98 @@ inline value::value(std::monostate)
 
 inline value::value(const array& arr)
     : _type(value_type::array)
-    , _raw_data(std::make_unique<array>(arr))
+    , _raw_data(std::make_shared<array>(arr))
 {
 }
 
 inline value::value(array&& arr)
     : _type(value_type::array)
-    , _raw_data(std::make_unique<array>(std::move(arr)))
+    , _raw_data(std::make_shared<array>(std::move(arr)))
 {
 }
 
 inline value::value(const object& obj)
     : _type(value_type::object)
-    , _raw_data(std::make_unique<object>(obj))
+    , _raw_data(std::make_shared<object>(obj))
 {
 }
 
 inline value::value(object&& obj)
     : _type(value_type::object)
-    , _raw_data(std::make_unique<object>(std::move(obj)))
+    , _raw_data(std::make_shared<object>(std::move(obj)))
 {
 }
 
 inline value::value(std::initializer_list<typename object::value_type> init_list)
     : _type(value_type::object)
-    , _raw_data(std::make_unique<object>(init_list))
+    , _raw_data(std::make_shared<object>(init_list))
+{
+}
+
+inline value::~value()
+{
+    if (!owns_nested()) {
+        return;
+    }
+    // Nested nodes are moved out and destroyed one at a time instead of by recursive destructors
+    std::vector<value> pending;
+    try {
+        release_nested(pending);
+        while (!pending.empty()) {
+            value node = std::move(pending.back());
+            pending.pop_back();
+            node.release_nested(pending);
+        }
+    }
+    catch (const std::bad_alloc&) {
+        // no memory for the stack: whatever is left, here and in pending, is destroyed recursively
+    }
+}
+
+inline bool value::owns_node() const noexcept
+{
+    if (const auto arr_ptr = std::get_if<array_ptr>(&_raw_data)) {
+        return *arr_ptr && exclusive(*arr_ptr);
+    }
+    if (const auto obj_ptr = std::get_if<object_ptr>(&_raw_data)) {
+        return *obj_ptr && exclusive(*obj_ptr);
+    }
+    return false;
+}
+
+inline bool value::owns_nested() const noexcept
 {
+    if (!owns_node()) {
+        return false;
+    }
+    if (const auto arr_ptr = std::get_if<array_ptr>(&_raw_data)) {
+        const auto& data = (*arr_ptr)->_array_data;
+        return std::any_of(data.cbegin(), data.cend(), [](const value& elem) { return elem.owns_node(); });
+    }
+    const auto& data = std::get<object_ptr>(_raw_data)->_object_data;
+    return std::any_of(data.cbegin(), data.cend(), [](const auto& pair) { return pair.second.owns_node(); });
 }
 
-inline value::~value() = default;
+inline void value::release_nested(std::vector<value>& pending)
+{
+    if (!owns_node()) {
+        return;
+    }
+    if (const auto arr_ptr = std::get_if<array_ptr>(&_raw_data)) {
+        for (auto& elem : (*arr_ptr)->_array_data) {
+            if (elem.owns_node()) {
+                pending.emplace_back(std::move(elem));
+            }
+        }
+    }
+    else {
+        for (auto& [key, elem] : std::get<object_ptr>(_raw_data)->_object_data) {
+            if (elem.owns_node()) {
+                pending.emplace_back(std::move(elem));
+            }
+        }
+    }
+}
 
 inline bool value::valid() const noexcept
 {
@@ -641,11 +752,15 @@ inline array& value::as_array()
 {
     if (empty()) {
         _type = value_type::array;
-        _raw_data = std::make_unique<array>();
+        _raw_data = std::make_shared<array>();
     }
 
     if (is_array()) {
-        return *std::get<array_ptr>(_raw_data);
+        detach();
+        auto& node = *std::get<array_ptr>(_raw_data);
+        // the caller may modify it
+        node._hash.reset();
+        return node;
     }
 
     throw exception("Type error: cannot convert to array, expected=array, " + value_info());
@@ -655,11 +770,15 @@ inline object& value::as_object()
 {
     if (empty()) {
         _type = value_type::object;
-        _raw_data = std::make_unique<object>();
+        _raw_data = std::make_shared<object>();
     }
 
     if (is_object()) {
-        return *std::get<object_ptr>(_raw_data);
+        detach();
+        auto& node = *std::get<object_ptr>(_raw_data);
+        // the caller may modify it
+        node._hash.reset();
+        return node;
     }
 
     throw exception("Type error: cannot convert to object, expected=object, " + value_info());
@@ -675,7 +794,50 @@ inline bool value::is_tuple_helper(std::index_sequence<Is...>) const noexcept
 template <typename... Ts>
 inline bool value::is_variant_helper(std::variant<Ts...>*) const noexcept
 {
-    return (is<Ts>() || ...);
+    using variant_t = std::variant<Ts...>;
+    if constexpr (_utils::is_tagged_variant<variant_t>) {
+        size_t index = std::variant_npos;
+        try {
+            // a user-provided index() may throw
+            index = variant_tag_index<variant_t>();
+        }
+        catch (...) {
+            return false;
+        }
+        return _value_impl_detail::visit_alternative<variant_t>(index, [&](auto alt) {
+            return is<std::variant_alternative_t<decltype(alt)::value, variant_t>>();
+        });
+    }
+    else {
+        return (is<Ts>() || ...);
+    }
+}
+
+template <typename variant_t>
+inline size_t value::variant_tag_index() const
+{
+    using tag_t = ext::variant_tag<variant_t>;
+    if constexpr (_utils::has_variant_tag_index<variant_t>::value) {
+        return tag_t().index(*this);
+    }
+    else {
+        static_assert(std::size(tag_t::tags) == std::variant_size_v<variant_t>, "one tag per variant alternative");
+        if (!is_object()) {
+            return std::variant_npos;
+        }
+        const auto& members = std::get<object_ptr>(_raw_data)->_object_data;
+        const auto tag = members.find(std::string_view(tag_t::key));
+        if (tag == members.end() || !tag->second.is_string()) {
+            return std::variant_npos;
+        }
+        const std::string& name = tag->second.as_basic_type_str();
+        for (size_t i = 0; i < std::size(tag_t::tags); ++i) {
+            if (tag_t::tags[i] == name) {
+                return i;
+            }
+        }
+        return std::variant_npos;
+    }
 }
 
 template <typename value_t>
@@ -687,14 +849,14 @@ inline value_t value::as() const&
     else if constexpr (_utils::has_from_json_in_member<value_t>::value) {
         value_t dst {};
         if (!dst.from_json(*this)) {
-            throw exception("Deserialization failed: from_json() returned false, " + value_info());
+            throw exception("Deserialization failed: from_json() returned false, " + failure_info());
         }
         return dst;
     }
     else if constexpr (_utils::has_from_json_in_templ_spec<value_t>::value) {
         value_t dst {};
         if (!ext::jsonization<value_t>().from_json(*this, dst)) {
-            throw exception("Deserialization failed: from_json() returned false, " + value_info());
+            throw exception("Deserialization failed: from_json() returned false, " + failure_info());
         }
         return dst;
     }
@@ -711,8 +873,9 @@ inline value_t value::as() &&
     }
     else if constexpr (_utils::has_from_json_in_member<value_t>::value) {
         value_t dst {};
-        if (!dst.from_json(*this)) {
-            throw exception("Deserialization failed: from_json() returned false, " + value_info());
+        // picks the rvalue overload generated by MEO_FROMJSON when there is one
+        if (!dst.from_json(std::move(*this))) {
+            throw exception("Deserialization failed: from_json() returned false, " + failure_info());
         }
         return dst;
     }
@@ -724,8 +887,350 @@ inline value_t value::as() &&
         return dst;
     }
     else {
-        return static_cast<value_t>(*this);
+        return static_cast<value_t>(std::move(*this));
+    }
+}
+
+template <typename value_t>
+inline std::optional<value_t> value::try_as() const&
+{
+    if constexpr (std::is_same_v<value, value_t>) {
+        return *this;
+    }
+    else if constexpr (_utils::has_from_json_in_member<value_t>::value) {
+        value_t dst {};
+        if (!dst.from_json(*this)) {
+            return std::nullopt;
+        }
+        return dst;
+    }
+    else if constexpr (_utils::has_from_json_in_templ_spec<value_t>::value) {
+        value_t dst {};
+        if (!ext::jsonization<value_t>().from_json(*this, dst)) {
+            return std::nullopt;
+        }
+        return dst;
+    }
+    else if constexpr (std::is_same_v<bool, value_t>) {
+        if (!is_boolean()) {
+            _utils::set_failure(this);
+            return std::nullopt;
+        }
+        return as_basic_type_str() == _utils::true_string();
+    }
+    else if constexpr (_utils::is_std_optional<value_t>) {
+        if (is_null()) {
+            return value_t {};
+        }
+        auto converted = try_as<typename value_t::value_type>();
+        if (!converted) {
+            return std::nullopt;
+        }
+        return value_t(std::move(converted));
+    }
+    else if constexpr (std::is_enum_v<value_t>) {
+        if (is_string()) {
+            auto enum_opt = _reflection::string_to_enum<value_t>(as_string_view());
+            if (!enum_opt) {
+                _utils::set_failure(this);
+                return std::nullopt;
+            }
+            return *enum_opt;
+        }
+        auto underlying = try_as<std::underlying_type_t<value_t>>();
+        return underlying ? std::optional<value_t>(static_cast<value_t>(*underlying)) : std::nullopt;
+    }
+    else if constexpr (std::is_arithmetic_v<value_t>) {
+        value_t result {};
+        if (!is_number()) {
+            _utils::set_failure(this);
+            return std::nullopt;
+        }
+        if constexpr (std::is_integral_v<value_t>) {
+            if (!_value_impl_detail::try_parse_integer(as_basic_type_str(), result)) {
+                _utils::set_failure(this);
+                return std::nullopt;
+            }
+        }
+        else if (!_value_impl_detail::try_parse_floating(as_basic_type_str(), result)) {
+            _utils::set_failure(this);
+            return std::nullopt;
+        }
+        return result;
+    }
+    else if constexpr (std::is_same_v<std::string, value_t>) {
+        if (!is_string()) {
+            _utils::set_failure(this);
+            return std::nullopt;
+        }
+        return as_basic_type_str();
+    }
+    else if constexpr (_utils::is_collection<value_t> && !std::is_same_v<array, value_t>) {
+        if (!is_array()) {
+            _utils::set_failure(this);
+            return std::nullopt;
+        }
+        const auto& raw = as_array()._array_data;
+        value_t result;
+        if constexpr (_utils::has_reserve<value_t>::value) {
+            result.reserve(raw.size());
+        }
+        for (const auto& val : raw) {
+            auto converted = val.template try_as<typename value_t::value_type>();
+            if (!converted) {
+                _utils::prepend_failure(this, &val, std::to_string(&val - raw.data()), [&] { return val.value_info(); });
+                return std::nullopt;
+            }
+            if constexpr (_utils::has_emplace_back<value_t>::value) {
+                result.emplace_back(std::move(*converted));
+            }
+            else {
+                result.emplace(std::move(*converted));
+            }
+        }
+        return result;
+    }
+    else if constexpr (_utils::is_fixed_array<value_t>) {
+        if (!is_array() || as_array().size() != _utils::fixed_array_size<value_t>) {
+            _utils::set_failure(this);
+            return std::nullopt;
+        }
+        value_t result;
+        for (size_t i = 0; i < _utils::fixed_array_size<value_t>; ++i) {
+            const value& val = as_array()[i];
+            auto converted = val.try_as<typename value_t::value_type>();
+            if (!converted) {
+                _utils::prepend_failure(this, &val, std::to_string(i), [&] { return val.value_info(); });
+                return std::nullopt;
+            }
+            result[i] = std::move(*converted);
+        }
+        return result;
+    }
+    else if constexpr (_utils::is_tuple_like<value_t>) {
+        if (!is_array() || as_array().size() != std::tuple_size_v<value_t>) {
+            _utils::set_failure(this);
+            return std::nullopt;
+        }
+        value_t result;
+        size_t index = 0;
+        const bool converted = std::apply(
+            [&](auto&... elems) {
+                const auto convert = [&](auto& elem) {
+                    const value& val = as_array()[index];
+                    auto elem_opt = val.template try_as<std::decay_t<decltype(elem)>>();
+                    if (elem_opt) {
+                        elem = std::move(*elem_opt);
+                    }
+                    else {
+                        _utils::prepend_failure(this, &val, std::to_string(index), [&] { return val.value_info(); });
+                    }
+                    ++index;
+                    return elem_opt.has_value();
+                };
+                return (convert(elems) && ...);
+            },
+            result);
+        return converted ? std::optional<value_t>(std::move(result)) : std::nullopt;
+    }
+    else if constexpr (_utils::is_variant<value_t>) {
+        return try_variant_helper(static_cast<value_t*>(nullptr));
+    }
+    else if constexpr (_utils::is_map<value_t> && !std::is_same_v<object, value_t>) {
+        if (!is_object()) {
+            _utils::set_failure(this);
+            return std::nullopt;
+        }
+        value_t result;
+        for (const auto& [key, val] : as_object()) {
+            auto converted = val.template try_as<typename value_t::mapped_type>();
+            if (!converted) {
+                _utils::prepend_failure(this, &val, key, [&] { return val.value_info(); });
+                return std::nullopt;
+            }
+            result.emplace(key, std::move(*converted));
+        }
+        return result;
+    }
+    else {
+        // remaining types are cheap to check, e.g. null, strings and json::array / json::object
+        if (!is<value_t>()) {
+            _utils::set_failure(this);
+            return std::nullopt;
+        }
+        return as<value_t>();
+    }
+}
+
+template <typename value_t>
+inline std::optional<value_t> value::try_as() &&
+{
+    if constexpr (std::is_same_v<value, value_t>) {
+        return std::move(*this);
+    }
+    else if constexpr (_utils::has_from_json_in_member<value_t>::value) {
+        value_t dst {};
+        if (!dst.from_json(std::move(*this))) {
+            return std::nullopt;
+        }
+        return dst;
+    }
+    else if constexpr (_utils::has_move_from_json_in_templ_spec<value_t>::value) {
+        value_t dst {};
+        if (!ext::jsonization<value_t>().move_from_json(std::move(*this), dst)) {
+            return std::nullopt;
+        }
+        return dst;
+    }
+    else if constexpr (std::is_same_v<std::string, value_t>) {
+        if (!is_string()) {
+            _utils::set_failure(this);
+            return std::nullopt;
+        }
+        return std::move(as_basic_type_str());
+    }
+    else if constexpr (_utils::is_std_optional<value_t>) {
+        if (is_null()) {
+            return value_t {};
+        }
+        auto converted = std::move(*this).template try_as<typename value_t::value_type>();
+        if (!converted) {
+            return std::nullopt;
+        }
+        return value_t(std::move(converted));
+    }
+    else if constexpr (
+        _utils::is_collection<value_t> && !std::is_same_v<array, value_t> && !_utils::has_from_json_in_templ_spec<value_t>::value) {
+        if (!is_array()) {
+            _utils::set_failure(this);
+            return std::nullopt;
+        }
+        auto& raw = as_array()._array_data;
+        value_t result;
+        if constexpr (_utils::has_reserve<value_t>::value) {
+            result.reserve(raw.size());
+        }
+        for (auto& val : raw) {
+            auto converted = std::move(val).template try_as<typename value_t::value_type>();
+            if (!converted) {
+                _utils::prepend_failure(this, &val, std::to_string(&val - raw.data()), [&] { return val.value_info(); });
+                return std::nullopt;
+            }
+            if constexpr (_utils::has_emplace_back<value_t>::value) {
+                result.emplace_back(std::move(*converted));
+            }
+            else {
+                result.emplace(std::move(*converted));
+            }
+        }
+        return result;
+    }
+    else if constexpr (
+        _utils::is_map<value_t> && !std::is_same_v<object, value_t> && !_utils::has_from_json_in_templ_spec<value_t>::value) {
+        if (!is_object()) {
+            _utils::set_failure(this);
+            return std::nullopt;
+        }
+        value_t result;
+        for (auto& [key, val] : as_object()) {
+            auto converted = std::move(val).template try_as<typename value_t::mapped_type>();
+            if (!converted) {
+                _utils::prepend_failure(this, &val, key, [&] { return val.value_info(); });
+                return std::nullopt;
+            }
+            result.emplace(key, std::move(*converted));
+        }
+        return result;
+    }
+    else if constexpr (_utils::is_tagged_variant<value_t>) {
+        const size_t index = variant_tag_index<value_t>();
+        if (index == std::variant_npos) {
+            _utils::set_failure(this, "variant tag matches no alternative, " + value_info());
+            return std::nullopt;
+        }
+        std::optional<value_t> result;
+        _value_impl_detail::visit_alternative<value_t>(index, [&](auto alt) {
+            auto converted = std::move(*this).template try_as<std::variant_alternative_t<decltype(alt)::value, value_t>>();
+            if (converted) {
+                result.emplace(std::in_place_index<decltype(alt)::value>, std::move(*converted));
+            }
+            return converted.has_value();
+        });
+        return result;
+    }
+    else {
+        // scalars gain nothing from moving, and untagged variant alternatives are tried one after another,
+        // so a failed attempt must leave the value intact
+        return static_cast<const value&>(*this).template try_as<value_t>();
+    }
+}
+
+template <typename... Ts>
+inline std::optional<std::variant<Ts...>> value::try_variant_helper(std::variant<Ts...>*) const
+{
+    using variant_t = std::variant<Ts...>;
+    std::optional<variant_t> result;
+    if constexpr (_utils::is_tagged_variant<variant_t>) {
+        const size_t index = variant_tag_index<variant_t>();
+        if (index == std::variant_npos) {
+            _utils::set_failure(this, "variant tag matches no alternative, " + value_info());
+            return result;
+        }
+        _value_impl_detail::visit_alternative<variant_t>(index, [&](auto alt) {
+            auto converted = try_as<std::variant_alternative_t<decltype(alt)::value, variant_t>>();
+            if (converted) {
+                result.emplace(std::in_place_index<decltype(alt)::value>, std::move(*converted));
+            }
+            return converted.has_value();
+        });
+        return result;
+    }
+    const auto try_alternative = [&](auto* tag) {
+        using alternative_t = std::remove_pointer_t<decltype(tag)>;
+        auto converted = try_as<alternative_t>();
+        if (converted) {
+            result.emplace(std::in_place_type<alternative_t>, std::move(*converted));
+        }
+        return converted.has_value();
+    };
+    if (!(try_alternative(static_cast<Ts*>(nullptr)) || ...)) {
+        // the alternatives' own failures say little about which one was meant
+        _utils::set_failure(this, "no variant alternative matches, " + value_info());
+    }
+    return result;
+}
+
+template <typename value_t>
+inline std::optional<value_t> value::try_as(conversion_error& error) const&
+{
+    auto result = try_as<value_t>();
+    if (!result) {
+        error = take_failure();
+    }
+    return result;
+}
+
+inline conversion_error value::take_failure() const
+{
+    auto& trail = _utils::failed_conversion();
+    if (trail.source != this) {
+        // nothing below this value recorded a failure, so it is the one that did not fit
+        return conversion_error { std::string(), value_info() };
+    }
+    trail.source = nullptr;
+    if (trail.reason.empty()) {
+        trail.reason = value_info();
+    }
+    return conversion_error { std::move(trail.path), std::move(trail.reason) };
+}
+
+inline std::string value::failure_info() const
+{
+    conversion_error error = take_failure();
+    if (error.path.empty()) {
+        return value_info();
     }
+    return "at " + error.path + " (" + error.reason + "), " + value_info();
 }
 
 inline const std::string& value::as_basic_type_str() const
@@ -762,71 +1267,490 @@ inline void value::clear() noexcept
 inline std::string value::to_string() const
 {
     std::string str;
-    dump_to(str);
+    write_compact(str);
     return str;
 }
 
-inline void value::dump_to(std::string& out) const
+inline void value::dump_to(std::string& out, bool ensure_ascii) const
+{
+    if (ensure_ascii) {
+        write_compact<true>(out);
+    }
+    else {
+        write_compact(out);
+    }
+}
+
+template <bool ensure_ascii, typename writer_t>
+inline void value::write_compact(writer_t& out) const
 {
     switch (_type) {
-    case value_type::null:
-        out += _utils::null_string();
+    case value_type::array:
+        write_compact_tree<ensure_ascii>(out, &as_array(), nullptr);
         break;
-    case value_type::boolean:
-    case value_type::number:
-        out += as_basic_type_str();
+    case value_type::object:
+        write_compact_tree<ensure_ascii>(out, nullptr, &as_object());
         break;
-    case value_type::string:
-        out.push_back('"');
-        _utils::append_escaped_string(out, as_basic_type_str());
-        out.push_back('"');
+    default:
+        write_scalar<ensure_ascii>(out);
         break;
-    case value_type::array:
-        as_array().dump_to(out);
+    }
+}
+
+template <bool ensure_ascii, typename writer_t>
+inline void value::write_scalar(writer_t& out) const
+{
+    switch (_type) {
+    case value_type::null:
+        out.append(_utils::null_string().data(), _utils::null_string().size());
         break;
-    case value_type::object:
-        as_object().dump_to(out);
+    case value_type::boolean:
+    case value_type::number:
+        out.append(as_basic_type_str().data(), as_basic_type_str().size());
+        break;
+    case value_type::string:
+        out.push_back('"');
+        _utils::append_escaped_string<ensure_ascii>(out, as_basic_type_str());
+        out.push_back('"');
         break;
     default:
         throw exception("Internal error: unknown value type, " + value_info());
     }
 }
 
-inline std::string value::format(size_t indent, size_t indent_times) const
+template <typename visitor_t>
+inline void value::walk_tree(visitor_t& visitor, const array* arr, const object* obj)
+{
+    struct frame
+    {
+        const array* arr = nullptr;
+        const object* obj = nullptr;
+        array::const_iterator arr_iter;
+        object::const_iterator obj_iter;
+        // members in the order the visitor asked for, empty for key order
+        std::vector<const object::value_type*> order;
+        size_t visited = 0;
+    };
+    std::vector<frame> stack;
+    auto open = [&](const array* child_arr, const object* child_obj) {
+        if (child_arr) {
+            // false if the visitor wrote the whole array itself
+            if (visitor.open_array(*child_arr, stack.size())) {
+                stack.push_back(frame { child_arr, nullptr, child_arr->_array_data.cbegin(), {}, {}, 0 });
+            }
+            return;
+        }
+        std::vector<const object::value_type*> order;
+        visitor.open_object(*child_obj, stack.size(), order);
+        stack.push_back(frame { nullptr, child_obj, {}, child_obj->_object_data.cbegin(), std::move(order), 0 });
+    };
+
+    open(arr, obj);
+    while (!stack.empty()) {
+        frame& top = stack.back();
+        const size_t depth = stack.size() - 1;
+        const value* child = nullptr;
+        if (top.arr) {
+            const auto& data = top.arr->_array_data;
+            if (top.arr_iter == data.cend()) {
+                visitor.close(true, depth);
+                stack.pop_back();
+                continue;
+            }
+            visitor.element(depth, top.arr_iter == data.cbegin());
+            child = &*top.arr_iter++;
+        }
+        else {
+            const object::value_type* member = nullptr;
+            if (!top.order.empty()) {
+                member = top.visited != top.order.size() ? top.order[top.visited] : nullptr;
+            }
+            else if (top.obj_iter != top.obj->_object_data.cend()) {
+                member = &*top.obj_iter++;
+            }
+            if (!member) {
+                visitor.close(false, depth);
+                stack.pop_back();
+                continue;
+            }
+            visitor.member(member->first, depth, top.visited++ == 0);
+            child = &member->second;
+        }
+
+        // top is invalidated from here on
+        if (child->is_array()) {
+            open(&child->as_array(), nullptr);
+        }
+        else if (child->is_object()) {
+            open(nullptr, &child->as_object());
+        }
+        else {
+            visitor.scalar(*child);
+        }
+    }
+}
+
+template <bool ensure_ascii, typename writer_t>
+inline void value::write_compact_tree(writer_t& out, const array* arr, const object* obj)
 {
-    std::string str;
-    format_to(str, indent, indent_times);
-    return str;
+    struct compact_visitor
+    {
+        writer_t& out;
+
+        bool open_array(const array&, size_t)
+        {
+            out.push_back('[');
+            return true;
+        }
+
+        void open_object(const object&, size_t, std::vector<const object::value_type*>&) { out.push_back('{'); }
+
+        void element(size_t, bool first)
+        {
+            if (!first) {
+                out.push_back(',');
+            }
+        }
+
+        void member(const std::string& key, size_t, bool first)
+        {
+            if (!first) {
+                out.push_back(',');
+            }
+            out.push_back('"');
+            _utils::append_escaped_string<ensure_ascii>(out, key);
+            out.push_back('"');
+            out.push_back(':');
+        }
+
+        void scalar(const value& val) { val.write_scalar<ensure_ascii>(out); }
+
+        void close(bool is_array, size_t) { out.push_back(is_array ? ']' : '}'); }
+    };
+
+    compact_visitor visitor { out };
+    walk_tree(visitor, arr, obj);
 }
 
-inline void value::format_to(std::string& out, size_t indent, size_t indent_times) const
+inline void value::format_to(std::string& out, _utils::indent_cache& indent, size_t indent_times) const
 {
     switch (_type) {
     case value_type::null:
     case value_type::boolean:
     case value_type::number:
     case value_type::string:
-        dump_to(out);
+        if (indent.options().ensure_ascii) {
+            write_scalar<true>(out);
+        }
+        else {
+            write_scalar<false>(out);
+        }
         break;
     case value_type::array:
-        as_array().format_to(out, indent, indent_times);
+        format_tree(out, indent, &as_array(), nullptr, indent_times);
         break;
     case value_type::object:
-        as_object().format_to(out, indent, indent_times);
+        format_tree(out, indent, nullptr, &as_object(), indent_times);
         break;
     default:
         throw exception("Internal error: unknown value type, " + value_info());
     }
 }
 
-inline std::string value::dumps(std::optional<size_t> indent) const
+inline void value::format_tree(std::string& out, _utils::indent_cache& indent, const array* arr, const object* obj, size_t indent_times)
+{
+    struct format_visitor
+    {
+        std::string& out;
+        _utils::indent_cache& indent;
+        // of the root
+        size_t indent_times;
+
+        bool open_array(const array& arr, size_t depth)
+        {
+            out.push_back('[');
+            if (!indent.options().compact_arrays || !_array_impl_detail::only_scalars(arr._array_data)) {
+                return true;
+            }
+            for (auto iter = arr._array_data.cbegin(); iter != arr._array_data.cend();) {
+                iter->format_to(out, indent, indent_times + depth);
+                if (++iter != arr._array_data.cend()) {
+                    out.append(", ");
+                }
+            }
+            out.push_back(']');
+            return false;
+        }
+
+        void open_object(const object&, size_t, std::vector<const object::value_type*>&) { out.push_back('{'); }
+
+        void element(size_t depth, bool first)
+        {
+            if (!first) {
+                out.push_back(',');
+            }
+            indent.newline(out, indent_times + depth + 1);
+        }
+
+        void member(const std::string& key, size_t depth, bool first)
+        {
+            element(depth, first);
+            out.push_back('"');
+            if (indent.options().ensure_ascii) {
+                _utils::append_escaped_string<true>(out, key);
+            }
+            else {
+                _utils::append_escaped_string(out, key);
+            }
+            out.push_back('"');
+            out.push_back(':');
+            out.push_back(' ');
+        }
+
+        void scalar(const value& val) { val.format_to(out, indent, 0); }
+
+        // the closing bracket goes on its own line, also for an empty array or object
+        void close(bool is_array, size_t depth)
+        {
+            indent.newline(out, indent_times + depth);
+            out.push_back(is_array ? ']' : '}');
+        }
+    };
+
+    format_visitor visitor { out, indent, indent_times };
+    walk_tree(visitor, arr, obj);
+}
+
+// Exact unless some strings need escaping, in which case the buffer grows as usual.
+inline size_t value::format_size(const format_options& options, size_t indent_times) const
+{
+    switch (_type) {
+    case value_type::null:
+        return _utils::null_string().size();
+    case value_type::boolean:
+    case value_type::number:
+        return as_basic_type_str().size();
+    case value_type::string:
+        return as_basic_type_str().size() + 2;
+    case value_type::array:
+        return format_size_tree(options, &as_array(), nullptr, indent_times);
+    case value_type::object:
+        return format_size_tree(options, nullptr, &as_object(), indent_times);
+    default:
+        return 0;
+    }
+}
+
+inline size_t value::format_size_tree(const format_options& options, const array* arr, const object* obj, size_t indent_times)
 {
-    return indent ? format(*indent) : to_string();
+    struct node
+    {
+        const array* arr = nullptr;
+        const object* obj = nullptr;
+        size_t indent_times = 0;
+    };
+    std::vector<node> pending { node { arr, obj, indent_times } };
+    size_t size = 0;
+    auto add_child = [&](const value& val, size_t child_indent_times) {
+        if (val.is_array()) {
+            pending.push_back(node { &val.as_array(), nullptr, child_indent_times });
+        }
+        else if (val.is_object()) {
+            pending.push_back(node { nullptr, &val.as_object(), child_indent_times });
+        }
+        else {
+            size += val.format_size(options, child_indent_times);
+        }
+    };
+
+    while (!pending.empty()) {
+        const node top = pending.back();
+        pending.pop_back();
+        const size_t line = 1 + options.indent * (top.indent_times + 1);
+        if (top.arr) {
+            const auto& data = top.arr->_array_data;
+            size += 2; // "[]"
+            if (options.compact_arrays && _array_impl_detail::only_scalars(data)) {
+                for (const auto& val : data) {
+                    size += val.format_size(options, top.indent_times + 1) + 2; // ", "
+                }
+                size -= data.empty() ? 0 : 2;
+                continue;
+            }
+            size += 1 + options.indent * top.indent_times; // closing line
+            for (const auto& val : data) {
+                size += line + 1; // ","
+                add_child(val, top.indent_times + 1);
+            }
+            size -= data.empty() ? 0 : 1;
+        }
+        else {
+            const auto& data = top.obj->_object_data;
+            size += 3 + options.indent * top.indent_times; // "{}" and the closing line
+            for (const auto& [key, val] : data) {
+                // "key": value,
+                size += line + key.size() + 5;
+                add_child(val, top.indent_times + 1);
+            }
+            size -= data.empty() ? 0 : 1;
+        }
+    }
+    return size;
+}
+
+inline std::string value::dumps(std::optional<size_t> indent, bool ensure_ascii) const
+{
+    if (indent) {
+        format_options options;
+        options.indent = *indent;
+        options.ensure_ascii = ensure_ascii;
+        return format(options);
+    }
+    std::string str;
+    dump_to(str, ensure_ascii);
+    return str;
 }
 
 inline std::string value::format(size_t indent) const
 {
-    return format(indent, 0);
+    return format(format_options { indent });
+}
+
+inline std::string value::format(const format_options& options) const
+{
+    std::string str;
+    str.reserve(format_size(options, 0));
+    _utils::indent_cache indent(options);
+    format_to(str, indent, 0);
+    return str;
+}
+
+inline std::string value::dumps_canonical() const
+{
+    std::string str;
+    dump_canonical_to(str);
+    return str;
+}
+
+inline void value::dump_canonical_to(std::string& out) const
+{
+    write_canonical(out);
+}
+
+template <typename sink_t, std::enable_if_t<std::is_invocable_v<sink_t&, std::string_view>, bool>>
+inline void value::dump_canonical_to(sink_t&& sink) const
+{
+    _utils::callback_writer<std::remove_reference_t<sink_t>> writer(sink);
+    write_canonical(writer);
+    writer.flush();
+}
+
+inline void value::dump_segments_to(segment_buffer& out) const
+{
+    write_compact(out);
+}
+
+template <typename writer_t>
+inline void value::write_canonical(writer_t& out) const
+{
+    switch (_type) {
+    case value_type::array:
+        write_canonical_tree(out, &as_array(), nullptr);
+        break;
+    case value_type::object:
+        write_canonical_tree(out, nullptr, &as_object());
+        break;
+    default:
+        write_canonical_scalar(out);
+        break;
+    }
+}
+
+template <typename writer_t>
+inline void value::write_canonical_scalar(writer_t& out) const
+{
+    switch (_type) {
+    case value_type::null:
+        out.append(_utils::null_string().data(), _utils::null_string().size());
+        break;
+    case value_type::boolean:
+        out.append(as_basic_type_str().data(), as_basic_type_str().size());
+        break;
+    case value_type::number:
+        if (const std::string& num = as_basic_type_str(); _utils::is_canonical_integer(num)) {
+            out.append(num.data(), num.size());
+        }
+        else {
+            // not as_double(), which rejects subnormals
+            double parsed = 0;
+            if (!_utils::parse_double(num, parsed) || !_utils::append_ecmascript_number(out, parsed)) {
+                throw exception("Cannot canonicalize number: not a finite double, " + value_info());
+            }
+        }
+        break;
+    case value_type::string:
+        out.push_back('"');
+        _utils::append_escaped_string(out, as_basic_type_str());
+        out.push_back('"');
+        break;
+    default:
+        throw exception("Internal error: unknown value type, " + value_info());
+    }
+}
+
+template <typename writer_t>
+inline void value::write_canonical_tree(writer_t& out, const array* arr, const object* obj)
+{
+    struct canonical_visitor
+    {
+        writer_t& out;
+
+        bool open_array(const array&, size_t)
+        {
+            out.push_back('[');
+            return true;
+        }
+
+        void open_object(const object& obj, size_t, std::vector<const object::value_type*>& order)
+        {
+            out.push_back('{');
+            // std::map already sorts by UTF-8 bytes, which matches UTF-16 order unless supplementary characters are involved
+            const auto& data = obj._object_data;
+            if (std::none_of(data.cbegin(), data.cend(), [](const auto& pair) { return _utils::has_supplementary_char(pair.first); })) {
+                return;
+            }
+            order.reserve(data.size());
+            for (const auto& pair : data) {
+                order.emplace_back(&pair);
+            }
+            std::sort(order.begin(), order.end(), [](const object::value_type* lhs, const object::value_type* rhs) {
+                return _utils::utf16_less(lhs->first, rhs->first);
+            });
+        }
+
+        void element(size_t, bool first)
+        {
+            if (!first) {
+                out.push_back(',');
+            }
+        }
+
+        void member(const std::string& key, size_t, bool first)
+        {
+            element(0, first);
+            out.push_back('"');
+            _utils::append_escaped_string(out, key);
+            out.push_back('"');
+            out.push_back(':');
+        }
+
+        void scalar(const value& val) { val.write_canonical_scalar(out); }
+
+        void close(bool is_array, size_t) { out.push_back(is_array ? ']' : '}'); }
+    };
+
+    canonical_visitor visitor { out };
+    walk_tree(visitor, arr, obj);
 }
 
 template <typename value_t>
@@ -853,25 +1777,320 @@ inline value& value::operator=(const value& rhs)
 
 inline value& value::operator=(value&& rhs) noexcept = default;
 
+inline size_t value::hash() const
+{
+    const _utils::hash_cache* root_cache = node_hash();
+    if (!root_cache) {
+        return scalar_hash();
+    }
+
+    // Post-order walk with an explicit stack, filling the cache of every node on the way.
+    // Cached subtrees, e.g. the untouched parts of a snapshot, are not descended into.
+    struct frame
+    {
+        const value* node = nullptr;
+        size_t seed = 0;
+        size_t index = 0;
+        object::const_iterator obj_iter;
+    };
+    std::vector<frame> stack;
+    size_t result = 0;
+    auto open = [&](const value& node, const _utils::hash_cache& cache) {
+        if (const size_t cached = cache.get()) {
+            result = cached;
+            return false;
+        }
+        const size_t size = node.is_array() ? node.as_array().size() : node.as_object().size();
+        frame top;
+        top.node = &node;
+        top.seed = _utils::hash_combine(static_cast<size_t>(node._type), size);
+        if (node.is_object()) {
+            top.obj_iter = node.as_object()._object_data.cbegin();
+        }
+        stack.push_back(top);
+        return true;
+    };
+
+    if (!open(*this, *root_cache)) {
+        return result;
+    }
+    while (!stack.empty()) {
+        frame& top = stack.back();
+        const value* child = nullptr;
+        if (top.node->is_array()) {
+            const auto& data = top.node->as_array()._array_data;
+            child = top.index < data.size() ? &data[top.index++] : nullptr;
+        }
+        else if (top.obj_iter != top.node->as_object()._object_data.cend()) {
+            const auto& [key, val] = *top.obj_iter++;
+            top.seed = _utils::hash_combine(top.seed, std::hash<std::string> {}(key));
+            child = &val;
+        }
+
+        if (!child) {
+            // 0 marks an empty cache
+            result = top.seed ? top.seed : 1;
+            top.node->node_hash()->set(result);
+            stack.pop_back();
+            if (!stack.empty()) {
+                stack.back().seed = _utils::hash_combine(stack.back().seed, result);
+            }
+            continue;
+        }
+
+        if (const auto child_cache = child->node_hash()) {
+            // top is invalidated if the child is pushed
+            if (!open(*child, *child_cache)) {
+                top.seed = _utils::hash_combine(top.seed, result);
+            }
+        }
+        else {
+            top.seed = _utils::hash_combine(top.seed, child->scalar_hash());
+        }
+    }
+    return result;
+}
+
+inline memory_stats value::memory_usage() const
+{
+    // shared_ptr control block from make_shared: vtable and two counters
+    constexpr size_t control_block = 2 * sizeof(void*);
+    // red-black tree node: color and three links, then the member
+    constexpr size_t map_node = 4 * sizeof(void*) + sizeof(object::raw_object::value_type);
+
+    memory_stats stats;
+    // nodes shared between snapshots are only counted on their first visit
+    std::unordered_set<const void*> shared_seen;
+    auto first_visit = [&shared_seen](const auto& node_ptr) {
+        return node_ptr.use_count() == 1 || shared_seen.emplace(node_ptr.get()).second;
+    };
+
+    std::vector<const value*> pending { this };
+    while (!pending.empty()) {
+        const value& val = *pending.back();
+        pending.pop_back();
+
+        switch (val._type) {
+        case value_type::null:
+            ++stats.nulls;
+            break;
+        case value_type::boolean:
+            ++stats.booleans;
+            break;
+        case value_type::number:
+            ++stats.numbers;
+            stats.strings += string_heap(val.as_basic_type_str());
+            break;
+        case value_type::string:
+            ++stats.string_values;
+            stats.strings += string_heap(val.as_basic_type_str());
+            break;
+        case value_type::array: {
+            const auto& node = std::get<array_ptr>(val._raw_data);
+            if (!first_visit(node)) {
+                break;
+            }
+            ++stats.arrays;
+            const auto& data = node->_array_data;
+            stats.containers += sizeof(array) + control_block;
+            stats.array_buffers += data.capacity() * sizeof(value);
+            stats.array_slack += (data.capacity() - data.size()) * sizeof(value);
+            for (const auto& elem : data) {
+                pending.emplace_back(&elem);
+            }
+            break;
+        }
+        case value_type::object: {
+            const auto& node = std::get<object_ptr>(val._raw_data);
+            if (!first_visit(node)) {
+                break;
+            }
+            ++stats.objects;
+            stats.containers += sizeof(object) + control_block;
+            for (const auto& [key, elem] : node->_object_data) {
+                stats.object_nodes += map_node;
+                stats.strings += string_heap(key);
+                pending.emplace_back(&elem);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return stats;
+}
+
+inline size_t value::compact()
+{
+    size_t reclaimed = 0;
+    auto trim_string = [&reclaimed](std::string& str) {
+        if (str.capacity() == str.size()) {
+            return;
+        }
+        const size_t before = string_heap(str);
+        str.shrink_to_fit();
+        reclaimed += before - string_heap(str);
+    };
+
+    std::vector<value*> pending { this };
+    while (!pending.empty()) {
+        value& val = *pending.back();
+        pending.pop_back();
+
+        switch (val._type) {
+        case value_type::number:
+        case value_type::string:
+            trim_string(std::get<std::string>(val._raw_data));
+            break;
+        case value_type::array: {
+            // other snapshots may be reading a shared node; its contents and hash stay valid otherwise
+            if (!val.owns_node()) {
+                break;
+            }
+            auto& data = std::get<array_ptr>(val._raw_data)->_array_data;
+            // shrink_to_fit() is only a request, so count what it actually gave back
+            const size_t capacity = data.capacity();
+            data.shrink_to_fit();
+            reclaimed += (capacity - data.capacity()) * sizeof(value);
+            for (auto& elem : data) {
+                pending.emplace_back(&elem);
+            }
+            break;
+        }
+        case value_type::object: {
+            if (!val.owns_node()) {
+                break;
+            }
+            auto& data = std::get<object_ptr>(val._raw_data)->_object_data;
+            for (auto iter = data.begin(); iter != data.end();) {
+                if (iter->first.capacity() == iter->first.size() || string_heap(iter->first) == 0) {
+                    pending.emplace_back(&iter->second);
+                    ++iter;
+                    continue;
+                }
+                // keys are const inside the map, so trim them through a node handle
+                auto next = std::next(iter);
+                auto node = data.extract(iter);
+                trim_string(node.key());
+                iter = data.insert(next, std::move(node));
+                pending.emplace_back(&iter->second);
+                iter = next;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return reclaimed;
+}
+
+inline size_t value::string_heap(const std::string& str) noexcept
+{
+    // strings up to the small string capacity live inside the std::string itself
+    static const size_t inline_capacity = std::string().capacity();
+    return str.capacity() > inline_capacity ? str.capacity() + 1 : 0;
+}
+
+inline const _utils::hash_cache* value::node_hash() const noexcept
+{
+    if (const auto arr_ptr = std::get_if<array_ptr>(&_raw_data)) {
+        return &(*arr_ptr)->_hash;
+    }
+    if (const auto obj_ptr = std::get_if<object_ptr>(&_raw_data)) {
+        return &(*obj_ptr)->_hash;
+    }
+    return nullptr;
+}
+
+inline size_t value::scalar_hash() const
+{
+    const size_t seed = static_cast<size_t>(_type);
+    // null compares equal regardless of its storage
+    return _type == value_type::null ? seed : _utils::hash_combine(seed, std::hash<std::string> {}(as_basic_type_str()));
+}
+
 inline bool value::operator==(const value& rhs) const
 {
-    if (_type != rhs._type) {
+    std::vector<std::pair<const value*, const value*>> pending;
+    if (!equal_shallow(*this, rhs, pending)) {
         return false;
     }
+    while (!pending.empty()) {
+        const auto [lhs_node, rhs_node] = pending.back();
+        pending.pop_back();
+        if (!equal_shallow(*lhs_node, *rhs_node, pending)) {
+            return false;
+        }
+    }
+    return true;
+}
 
-    switch (_type) {
+inline bool value::equal_shallow(
+    const value& lhs,
+    const value& rhs,
+    std::vector<std::pair<const value*, const value*>>& pending)
+{
+    if (lhs._type != rhs._type) {
+        return false;
+    }
+
+    auto equal_child = [&pending](const value& lhs_child, const value& rhs_child) {
+        if (lhs_child._type == rhs_child._type && (lhs_child.is_array() || lhs_child.is_object())) {
+            pending.emplace_back(&lhs_child, &rhs_child);
+            return true;
+        }
+        return equal_shallow(lhs_child, rhs_child, pending);
+    };
+
+    switch (lhs._type) {
     case value_type::null:
-        return rhs.is_null();
+        return true;
     case value_type::boolean:
     case value_type::number:
     case value_type::string:
-        return _raw_data == rhs._raw_data;
-    case value_type::array:
-        return as_array() == rhs.as_array();
-    case value_type::object:
-        return as_object() == rhs.as_object();
+        return lhs._raw_data == rhs._raw_data;
+    case value_type::array: {
+        const auto& lhs_ptr = std::get<array_ptr>(lhs._raw_data);
+        const auto& rhs_ptr = std::get<array_ptr>(rhs._raw_data);
+        // snapshots of one document share their nodes
+        if (lhs_ptr == rhs_ptr) {
+            return true;
+        }
+        const auto& lhs_data = lhs_ptr->_array_data;
+        const auto& rhs_data = rhs_ptr->_array_data;
+        if (lhs_data.size() != rhs_data.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < lhs_data.size(); ++i) {
+            if (!equal_child(lhs_data[i], rhs_data[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    case value_type::object: {
+        const auto& lhs_ptr = std::get<object_ptr>(lhs._raw_data);
+        const auto& rhs_ptr = std::get<object_ptr>(rhs._raw_data);
+        if (lhs_ptr == rhs_ptr) {
+            return true;
+        }
+        const auto& lhs_data = lhs_ptr->_object_data;
+        const auto& rhs_data = rhs_ptr->_object_data;
+        if (lhs_data.size() != rhs_data.size()) {
+            return false;
+        }
+        for (auto lhs_iter = lhs_data.cbegin(), rhs_iter = rhs_data.cbegin(); lhs_iter != lhs_data.cend();
+             ++lhs_iter, ++rhs_iter) {
+            if (lhs_iter->first != rhs_iter->first || !equal_child(lhs_iter->second, rhs_iter->second)) {
+                return false;
+            }
+        }
+        return true;
+    }
     default:
-        throw exception("Internal error: unknown value type, " + value_info());
+        throw exception("Internal error: unknown value type, " + lhs.value_info());
     }
 }
 
@@ -988,7 +2207,7 @@ inline value& value::operator[](const std::string& key)
 {
     if (empty()) {
         _type = value_type::object;
-        _raw_data = std::make_unique<object>();
+        _raw_data = std::make_shared<object>();
     }
 
     return as_object()[key];
@@ -998,7 +2217,7 @@ inline value& value::operator[](std::string&& key)
 {
     if (empty()) {
         _type = value_type::object;
-        _raw_data = std::make_unique<object>();
+        _raw_data = std::make_shared<object>();
     }
 
     return as_object()[std::move(key)];
@@ -1008,7 +2227,7 @@ inline value value::operator|(const object& rhs) const&
 {
     value result;
     result._type = value_type::object;
-    result._raw_data = std::make_unique<object>(as_object() | rhs);
+    result._raw_data = std::make_shared<object>(as_object() | rhs);
     return result;
 }
 
@@ -1016,7 +2235,7 @@ inline value value::operator|(object&& rhs) const&
 {
     value result;
     result._type = value_type::object;
-    result._raw_data = std::make_unique<object>(as_object() | std::move(rhs));
+    result._raw_data = std::make_shared<object>(as_object() | std::move(rhs));
     return result;
 }
 
@@ -1024,7 +2243,7 @@ inline value value::operator|(const object& rhs) &&
 {
     value result;
     result._type = value_type::object;
-    result._raw_data = std::make_unique<object>(std::move(as_object()) | rhs);
+    result._raw_data = std::make_shared<object>(std::move(as_object()) | rhs);
     return result;
 }
 
@@ -1032,7 +2251,7 @@ inline value value::operator|(object&& rhs) &&
 {
     value result;
     result._type = value_type::object;
-    result._raw_data = std::make_unique<object>(std::move(as_object()) | std::move(rhs));
+    result._raw_data = std::make_shared<object>(std::move(as_object()) | std::move(rhs));
     return result;
 }
 
@@ -1052,7 +2271,7 @@ inline value value::operator+(const array& rhs) const&
 {
     value result;
     result._type = value_type::array;
-    result._raw_data = std::make_unique<array>(as_array() + rhs);
+    result._raw_data = std::make_shared<array>(as_array() + rhs);
     return result;
 }
 
@@ -1060,7 +2279,7 @@ inline value value::operator+(array&& rhs) const&
 {
     value result;
     result._type = value_type::array;
-    result._raw_data = std::make_unique<array>(as_array() + std::move(rhs));
+    result._raw_data = std::make_shared<array>(as_array() + std::move(rhs));
     return result;
 }
 
@@ -1068,7 +2287,7 @@ inline value value::operator+(const array& rhs) &&
 {
     value result;
     result._type = value_type::array;
-    result._raw_data = std::make_unique<array>(std::move(as_array()) + rhs);
+    result._raw_data = std::make_shared<array>(std::move(as_array()) + rhs);
     return result;
 }
 
@@ -1076,7 +2295,7 @@ inline value value::operator+(array&& rhs) &&
 {
     value result;
     result._type = value_type::array;
-    result._raw_data = std::make_unique<array>(std::move(as_array()) + std::move(rhs));
+    result._raw_data = std::make_shared<array>(std::move(as_array()) + std::move(rhs));
     return result;
 }
 
@@ -1092,6 +2311,88 @@ inline value& value::operator+=(array&& rhs)
     return *this;
 }
 
+inline value& value::merge(const value& rhs, array_merge arrays)
+{
+    // rhs may be this value or part of it: the snapshot keeps reading the original nodes, while every
+    // node written here is detached from it first
+    const value src = rhs.snapshot();
+    merge_tree(*this, src, arrays);
+    return *this;
+}
+
+inline value& value::merge(value&& rhs, array_merge arrays)
+{
+    if (&rhs == this) {
+        return merge(static_cast<const value&>(rhs), arrays);
+    }
+    // taken out first in case rhs is part of this value
+    value src = std::move(rhs);
+    merge_tree(*this, src, arrays);
+    return *this;
+}
+
+// src_t is const value when copying from rhs and value when moving out of it
+template <typename src_t>
+inline void value::merge_tree(value& dst, src_t& src, array_merge arrays)
+{
+    constexpr bool move_src = !std::is_const_v<src_t>;
+
+    std::vector<std::pair<value*, src_t*>> pending { { &dst, &src } };
+    while (!pending.empty()) {
+        const auto [to, from] = pending.back();
+        pending.pop_back();
+
+        if (to->is_object() && from->is_object()) {
+            auto& dst_data = to->as_object()._object_data;
+            if constexpr (move_src) {
+                auto& src_data = from->as_object()._object_data;
+                // Members missing here are spliced over without copying or allocating,
+                // the colliding ones stay in src
+                dst_data.merge(src_data);
+                for (auto& [key, val] : src_data) {
+                    pending.emplace_back(&dst_data.find(key)->second, &val);
+                }
+            }
+            else {
+                for (const auto& [key, val] : from->as_object()._object_data) {
+                    auto iter = dst_data.lower_bound(key);
+                    if (iter != dst_data.end() && iter->first == key) {
+                        pending.emplace_back(&iter->second, &val);
+                    }
+                    else {
+                        dst_data.emplace_hint(iter, key, val);
+                    }
+                }
+            }
+        }
+        else if (to->is_array() && from->is_array() && arrays != array_merge::replace) {
+            auto& dst_data = to->as_array()._array_data;
+            auto& src_data = from->as_array()._array_data;
+            const size_t merged = arrays == array_merge::by_index ? std::min(dst_data.size(), src_data.size()) : 0;
+            // before taking pointers to the elements
+            dst_data.reserve(dst_data.size() + src_data.size() - merged);
+            for (size_t i = 0; i < merged; ++i) {
+                pending.emplace_back(&dst_data[i], &src_data[i]);
+            }
+            if constexpr (move_src) {
+                dst_data.insert(
+                    dst_data.end(),
+                    std::make_move_iterator(src_data.begin() + merged),
+                    std::make_move_iterator(src_data.end()));
+            }
+            else {
+                dst_data.insert(dst_data.end(), src_data.begin() + merged, src_data.end());
+            }
+        }
+        else if constexpr (move_src) {
+            *to = std::move(*from);
+        }
+        else {
+            *to = *from;
+        }
+    }
+}
+
 template <typename... args_t>
 inline value::value(value_type type, args_t&&... args)
     : _type(type)
@@ -1100,20 +2401,67 @@ inline value::value(value_type type, args_t&&... args)
     static_assert(std::is_constructible_v<var_t, args_t...>, "Parameter can't be used to construct a var_t");
 }
 
+inline size_t& value::copy_depth() noexcept
+{
+    thread_local size_t depth = 0;
+    return depth;
+}
+
 inline typename value::var_t value::deep_copy(const var_t& src)
 {
-    var_t dst;
     if (const auto string_ptr = std::get_if<std::string>(&src)) {
-        dst = *string_ptr;
-    }
-    else if (const auto arr_ptr = std::get_if<array_ptr>(&src)) {
-        dst = std::make_unique<array>(**arr_ptr);
-    }
-    else if (const auto obj_ptr = std::get_if<object_ptr>(&src)) {
-        dst = std::make_unique<object>(**obj_ptr);
+        return *string_ptr;
+    }
+    if (size_t& depth = copy_depth(); depth < recursive_copy_depth) {
+        struct nested
+        {
+            size_t& depth;
+            ~nested() { --depth; }
+        } guard { ++depth };
+        if (const auto arr_ptr = std::get_if<array_ptr>(&src)) {
+            return std::make_shared<array>(**arr_ptr);
+        }
+        return std::make_shared<object>(*std::get<object_ptr>(src));
     }
-    else {
-        // maybe invalid_value
+
+    // Each array and object node is copied with its scalars, and its nested nodes are queued,
+    // so the copy never recurses
+    var_t dst;
+    std::vector<std::pair<const var_t*, var_t*>> pending { { &src, &dst } };
+    auto copy_child = [&pending](const value& src_child, value& dst_child) {
+        dst_child._type = src_child._type;
+        if (const auto string_ptr = std::get_if<std::string>(&src_child._raw_data)) {
+            dst_child._raw_data = *string_ptr;
+        }
+        else {
+            pending.emplace_back(&src_child._raw_data, &dst_child._raw_data);
+        }
+    };
+
+    while (!pending.empty()) {
+        const auto [from, to] = pending.back();
+        pending.pop_back();
+        if (const auto string_ptr = std::get_if<std::string>(from)) {
+            *to = *string_ptr;
+        }
+        else if (const auto arr_ptr = std::get_if<array_ptr>(from)) {
+            const auto& src_data = (*arr_ptr)->_array_data;
+            auto node = std::make_shared<array>();
+            // reserved, so the queued children stay in place
+            node->_array_data.reserve(src_data.size());
+            for (const auto& elem : src_data) {
+                copy_child(elem, node->_array_data.emplace_back());
+            }
+            *to = std::move(node);
+        }
+        else if (const auto obj_ptr = std::get_if<object_ptr>(from)) {
+            const auto& src_data = (*obj_ptr)->_object_data;
+            auto node = std::make_shared<object>();
+            for (const auto& [key, elem] : src_data) {
+                copy_child(elem, node->_object_data.emplace_hint(node->_object_data.end(), key, value())->second);
+            }
+            *to = std::move(node);
+        }
     }
 
     return dst;
@@ -1151,8 +2499,19 @@ inline value::value(std::variant<Ts...>&& var)
 template <typename... Ts>
 inline std::variant<Ts...> value::to_variant_helper() const&
 {
-    std::variant<Ts...> result;
-    if (!((is<Ts>() ? (result = as<Ts>(), true) : false) || ...)) {
+    using variant_t = std::variant<Ts...>;
+    variant_t result;
+    if constexpr (_utils::is_tagged_variant<variant_t>) {
+        // the tag picks the alternative, so only that one is converted
+        const bool converted = _value_impl_detail::visit_alternative<variant_t>(variant_tag_index<variant_t>(), [&](auto alt) {
+            result.template emplace<decltype(alt)::value>(as<std::variant_alternative_t<decltype(alt)::value, variant_t>>());
+            return true;
+        });
+        if (!converted) {
+            throw exception("Type error: variant tag matches no alternative, " + value_info());
+        }
+    }
+    else if (!((is<Ts>() ? (result = as<Ts>(), true) : false) || ...)) {
         throw exception("Type error: cannot convert to any variant alternative, " + value_info());
     }
     return result;
@@ -1161,8 +2520,19 @@ inline std::variant<Ts...> value::to_variant_helper() const&
 template <typename... Ts>
 inline std::variant<Ts...> value::move_to_variant_helper() &&
 {
-    std::variant<Ts...> result;
-    if (!((is<Ts>() ? (result = std::move(*this).as<Ts>(), true) : false) || ...)) {
+    using variant_t = std::variant<Ts...>;
+    variant_t result;
+    if constexpr (_utils::is_tagged_variant<variant_t>) {
+        const bool converted = _value_impl_detail::visit_alternative<variant_t>(variant_tag_index<variant_t>(), [&](auto alt) {
+            result.template emplace<decltype(alt)::value>(
+                std::move(*this).template as<std::variant_alternative_t<decltype(alt)::value, variant_t>>());
+            return true;
+        });
+        if (!converted) {
+            throw exception("Type error: variant tag matches no alternative, " + value_info());
+        }
+    }
+    else if (!((is<Ts>() ? (result = std::move(*this).as<Ts>(), true) : false) || ...)) {
         throw exception("Type error: cannot convert to any variant alternative, " + value_info());
     }
     return result;
@@ -72,6 +72,8 @@ struct packed_bytes_trait_uint64
 
     __packed_bytes_strong_inline static value_type bitwise_or(value_type a, value_type b) { return a | b; }
 
+    __packed_bytes_strong_inline static value_type non_ascii(value_type x) { return x & UINT64_C(0x8080808080808080); }
+
     __packed_bytes_strong_inline static size_t first_nonzero_byte(value_type x)
     {
         if (_bitops::is_little_endian()) {
@@ -116,6 +118,8 @@ struct packed_bytes_trait_uint32
 
     __packed_bytes_strong_inline static value_type bitwise_or(value_type a, value_type b) { return a | b; }
 
+    __packed_bytes_strong_inline static value_type non_ascii(value_type x) { return x & UINT32_C(0x80808080); }
+
     __packed_bytes_strong_inline static size_t first_nonzero_byte(value_type x)
     {
         if (_bitops::is_little_endian()) {
@@ -34,6 +34,8 @@ struct packed_bytes_trait_neon
 
     __packed_bytes_strong_inline static value_type bitwise_or(value_type a, value_type b) { return vorrq_u8(a, b); }
 
+    __packed_bytes_strong_inline static value_type non_ascii(value_type x) { return vcgeq_u8(x, vdupq_n_u8(0x80)); }
+
     __packed_bytes_strong_inline static bool is_all_zero(value_type x)
     {
 #ifdef __packed_bytes_trait_arm64
@@ -42,6 +42,9 @@ struct packed_bytes_trait_sse
 
     __packed_bytes_strong_inline static value_type bitwise_or(value_type a, value_type b) { return _mm_or_si128(a, b); }
 
+    // bytes >= 0x80 are negative as signed chars
+    __packed_bytes_strong_inline static value_type non_ascii(value_type x) { return _mm_cmplt_epi8(x, _mm_setzero_si128()); }
+
     __packed_bytes_strong_inline static bool is_all_zero(value_type x)
     {
 #if defined(__SSE4_1__) || defined(__AVX2__) || defined(_MSC_VER)
@@ -104,6 +107,8 @@ struct packed_bytes_trait_avx2
 
     __packed_bytes_strong_inline static value_type bitwise_or(value_type a, value_type b) { return _mm256_or_si256(a, b); }
 
+    __packed_bytes_strong_inline static value_type non_ascii(value_type x) { return _mm256_cmpgt_epi8(_mm256_setzero_si256(), x); }
+
     __packed_bytes_strong_inline static bool is_all_zero(value_type x) { return (bool)_mm256_testz_si256(x, x); }
 
     __packed_bytes_strong_inline static size_t first_nonzero_byte(value_type x)
@@ -6,16 +6,26 @@
 #include <fstream>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "../common/types.hpp"
 #include "packed_bytes.hpp"
 
 namespace json
 {
+namespace _jsonization_helper
+{
+class text_reader;
+}
+
 // ****************************
 // *      parser declare      *
 // ****************************
 
+// Nesting limit of parse() and parsec(); deeper documents fail like malformed ones
+inline constexpr size_t default_max_depth = 10000;
+
 template <bool accept_jsonc = false, typename parsing_t = void, typename accel_traits = _packed_bytes::packed_bytes_trait_max>
 class parser
 {
@@ -25,29 +35,75 @@ public:
 public:
     ~parser() noexcept = default;
 
-    static std::optional<value> parse(const parsing_t& content);
+    static std::optional<value> parse(const parsing_t& content, size_t max_depth = default_max_depth);
+    // builds the frozen buffer while parsing, without json::value nodes in between
+    static std::optional<frozen_value> parse_frozen(const parsing_t& content, size_t max_depth = default_max_depth);
 
 private:
-    parser(parsing_iter_t cbegin, parsing_iter_t cend) noexcept
+    friend class _jsonization_helper::text_reader;
+
+    parser(parsing_iter_t cbegin, parsing_iter_t cend, size_t max_depth = default_max_depth) noexcept
         : _cur(cbegin)
         , _end(cend)
+        , _max_depth(max_depth)
     {
         ;
     }
 
+    // An open array or object
+    struct level
+    {
+        bool is_object = false;
+        // where the elements of this array start in nesting::elements
+        size_t first_element = 0;
+        object members;
+        std::string key;
+    };
+
+    // Kept per thread across parses, so the buffers are reused
+    struct nesting
+    {
+        std::vector<level> levels;
+        // Elements of all open arrays, innermost last. An array is moved into an exactly sized vector
+        // once its closing bracket is seen, so it costs one allocation and no regrowth.
+        typename array::raw_array elements;
+    };
+
+    static nesting& nesting_state();
+    // Gives back the scratch buffers after an unusually large document, so a thread does not hold on
+    // to its peak for good
+    static void trim_nesting(nesting& state);
+
+    // Receivers of walk_nested(): the open levels, their keys, scalars and closed children
+    class value_sink;
+    class frozen_sink;
+
+    // scratch kept between parses, about 768 KiB of elements
+    static constexpr size_t retained_elements = 16384;
+    static constexpr size_t retained_levels = 1024;
+
     std::optional<value> parse();
     value parse_value();
 
     value parse_null();
     value parse_boolean();
     value parse_number();
+    bool skip_number();
     // parse and return a value whose type is value_type::string
     value parse_string();
-    value parse_array();
-    value parse_object();
+    // arrays and objects, walked with an explicit stack of levels instead of recursion
+    value parse_nested();
+    // the same walk as parse_nested(), appending to a frozen_value instead; false on malformed input
+    bool parse_frozen_nested(frozen_value::builder& build, uint32_t& result);
+    // The walk behind both: brackets, separators and the depth limit are checked here, and sink_t
+    // keeps what the levels hold. False on malformed input.
+    template <typename sink_t>
+    bool walk_nested(sink_t& sink);
 
     // parse and return a std::string
     std::optional<std::string> parse_stdstring();
+    // parse and append to result, so a buffer can be reused
+    bool parse_stdstring(std::string& result);
 
     bool skip_string_literal_with_accel();
     bool skip_whitespace() noexcept;
@@ -58,27 +114,131 @@ private:
 private:
     parsing_iter_t _cur;
     parsing_iter_t _end;
+    size_t _max_depth = default_max_depth;
 };
 
+namespace _jsonization_helper
+{
+// Reads JSON text straight into C++ objects, see json::parse_into.
+// Reflected types, strings, numbers, booleans, std::optional, sequence containers and string-keyed maps are
+// filled without creating json::value nodes; other types are parsed into a json::value for that subtree only.
+// Nesting deeper than default_max_depth fails, as it does in parse().
+class text_reader
+{
+public:
+    explicit text_reader(std::string_view content) noexcept
+        : _content(content)
+        , _parser(content.cbegin(), content.cend())
+    {
+    }
+
+    // whole document: value and nothing but whitespace after it
+    template <typename T>
+    bool read_document(T& out);
+
+    // value at the current position
+    template <typename T>
+    bool read(T& out);
+
+    // calls on_member(std::string_view key) for every member, which must consume the member value
+    template <typename func_t>
+    bool read_object(func_t&& on_member);
+
+    bool skip_value();
+
+    // innermost key whose value could not be loaded
+    const std::string& error_key() const noexcept { return _error_key; }
+
+    void set_error_key(std::string_view key)
+    {
+        if (_error_key.empty()) {
+            _error_key = key;
+        }
+    }
+
+private:
+    template <typename T>
+    bool read_number(T& out);
+    template <typename T>
+    bool read_sequence(T& out);
+    // bodies of read_object() and read_sequence(), which count the nesting
+    template <typename func_t>
+    bool read_members(func_t& on_member);
+    template <typename T>
+    bool read_elements(T& out);
+    template <typename T>
+    bool read_map(T& out);
+    template <typename T>
+    bool read_through_value(T& out);
+
+    bool read_literal(std::string_view literal);
+
+    const char* to_pointer(std::string_view::const_iterator iter) const noexcept
+    {
+        return _content.data() + (iter - _content.cbegin());
+    }
+
+    std::string_view _content;
+    parser<false, std::string_view> _parser;
+    // reused for member keys, skipped strings and number text
+    std::string _key;
+    std::string _scratch;
+    std::string _error_key;
+    // skip_value() walks unknown values with this stack of closing brackets instead of recursing
+    std::string _closers;
+    // arrays and objects open in read_object() and read_sequence(), limited like parse()
+    size_t _depth = 0;
+};
+} // namespace _jsonization_helper
+
+namespace _utils
+{
+template <typename T, typename = void>
+struct has_from_json_text_in_member : std::false_type
+{
+};
+
+template <typename T>
+struct has_from_json_text_in_member<
+    T,
+    std::void_t<decltype(std::declval<T&>().from_json_text(std::declval<_jsonization_helper::text_reader&>()))>>
+    : std::true_type
+{
+};
+} // namespace _utils
+
 // ***************************
 // *      utils declare      *
 // ***************************
 
 template <typename parsing_t>
-std::optional<value> parse(const parsing_t& content);
+std::optional<value> parse(const parsing_t& content, size_t max_depth = default_max_depth);
 
-std::optional<value> parse(const char* content);
+std::optional<value> parse(const char* content, size_t max_depth = default_max_depth);
 
 template <typename parsing_t>
-std::optional<value> parsec(const parsing_t& content);
+std::optional<frozen_value> parse_frozen(const parsing_t& content, size_t max_depth = default_max_depth);
 
-std::optional<value> parsec(const char* content);
+std::optional<frozen_value> parse_frozen(const char* content, size_t max_depth = default_max_depth);
+
+template <typename parsing_t>
+std::optional<value> parsec(const parsing_t& content, size_t max_depth = default_max_depth);
+
+std::optional<value> parsec(const char* content, size_t max_depth = default_max_depth);
 
 std::optional<value> parse(std::istream& istream, bool check_bom = false, bool with_commets = false);
 
 template <typename path_t>
 std::optional<value> open(const path_t& path, bool check_bom = false, bool with_commets = false);
 
+// Parses content directly into out, which is typically a MEO_FROMJSON type, without building a json::value.
+// Unknown keys are skipped. On failure out may be partially assigned.
+template <typename T>
+bool parse_into(std::string_view content, T& out);
+
+template <typename T>
+bool parse_into(std::string_view content, T& out, std::string& error_key);
+
 namespace literals
 {
 value operator""_json(const char* str, size_t len);
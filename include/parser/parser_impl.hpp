@@ -9,9 +9,27 @@ namespace json
 // *************************
 
 template <bool accept_jsonc, typename parsing_t, typename accel_traits>
-inline std::optional<value> parser<accept_jsonc, parsing_t, accel_traits>::parse(const parsing_t& content)
+inline std::optional<value> parser<accept_jsonc, parsing_t, accel_traits>::parse(const parsing_t& content, size_t max_depth)
 {
-    return parser<accept_jsonc, parsing_t, accel_traits>(content.cbegin(), content.cend()).parse();
+    return parser<accept_jsonc, parsing_t, accel_traits>(content.cbegin(), content.cend(), max_depth).parse();
+}
+
+template <bool accept_jsonc, typename parsing_t, typename accel_traits>
+inline typename parser<accept_jsonc, parsing_t, accel_traits>::nesting& parser<accept_jsonc, parsing_t, accel_traits>::nesting_state()
+{
+    thread_local nesting instance;
+    return instance;
+}
+
+template <bool accept_jsonc, typename parsing_t, typename accel_traits>
+inline void parser<accept_jsonc, parsing_t, accel_traits>::trim_nesting(nesting& state)
+{
+    if (state.elements.capacity() > retained_elements) {
+        typename array::raw_array().swap(state.elements);
+    }
+    if (state.levels.capacity() > retained_levels) {
+        std::vector<level>().swap(state.levels);
+    }
 }
 
 template <bool accept_jsonc, typename parsing_t, typename accel_traits>
@@ -21,18 +39,13 @@ inline std::optional<value> parser<accept_jsonc, parsing_t, accel_traits>::parse
         return std::nullopt;
     }
 
-    value result_value;
-    switch (*_cur) {
-    case '[':
-        result_value = parse_array();
-        break;
-    case '{':
-        result_value = parse_object();
-        break;
-    default: // A JSON payload should be an object or array
+    // A JSON payload should be an object or array
+    if (*_cur != '[' && *_cur != '{') {
         return std::nullopt;
     }
 
+    value result_value = parse_nested();
+
     if (!result_value.valid()) {
         return std::nullopt;
     }
@@ -69,9 +82,8 @@ inline value parser<accept_jsonc, parsing_t, accel_traits>::parse_value()
     case '"':
         return parse_string();
     case '[':
-        return parse_array();
     case '{':
-        return parse_object();
+        return parse_nested();
     default:
         return invalid_value();
     }
@@ -125,39 +137,48 @@ template <bool accept_jsonc, typename parsing_t, typename accel_traits>
 inline value parser<accept_jsonc, parsing_t, accel_traits>::parse_number()
 {
     const auto first = _cur;
+    if (!skip_number()) {
+        return invalid_value();
+    }
+    return value(value::value_type::number, std::string(first, _cur));
+}
+
+template <bool accept_jsonc, typename parsing_t, typename accel_traits>
+inline bool parser<accept_jsonc, parsing_t, accel_traits>::skip_number()
+{
     if (*_cur == '-') {
         ++_cur;
     }
 
     // numbers cannot have leading zeroes
     if (_cur != _end && *_cur == '0' && _cur + 1 != _end && std::isdigit(static_cast<unsigned char>(*(_cur + 1)))) {
-        return invalid_value();
+        return false;
     }
 
     if (!skip_digit()) {
-        return invalid_value();
+        return false;
     }
 
     if (*_cur == '.') {
         ++_cur;
         if (!skip_digit()) {
-            return invalid_value();
+            return false;
         }
     }
 
     if (*_cur == 'e' || *_cur == 'E') {
         if (++_cur == _end) {
-            return invalid_value();
+            return false;
         }
         if (*_cur == '+' || *_cur == '-') {
             ++_cur;
         }
         if (!skip_digit()) {
-            return invalid_value();
+            return false;
         }
     }
 
-    return value(value::value_type::number, std::string(first, _cur));
+    return true;
 }
 
 template <bool accept_jsonc, typename parsing_t, typename accel_traits>
@@ -170,168 +191,390 @@ inline value parser<accept_jsonc, parsing_t, accel_traits>::parse_string()
     return value(value::value_type::string, std::move(string_opt).value());
 }
 
+// Levels of json::value in the reused nesting state
 template <bool accept_jsonc, typename parsing_t, typename accel_traits>
-inline value parser<accept_jsonc, parsing_t, accel_traits>::parse_array()
+class parser<accept_jsonc, parsing_t, accel_traits>::value_sink
 {
-    if (*_cur == '[') {
-        ++_cur;
-    }
-    else {
-        return invalid_value();
+public:
+    explicit value_sink(nesting& state) noexcept
+        : _state(state)
+    {
     }
 
-    if (!skip_whitespace()) {
-        return invalid_value();
-    }
-    else if (*_cur == ']') {
-        ++_cur;
-        // empty array
-        return array();
-    }
+    size_t depth() const noexcept { return _depth; }
 
-    typename array::raw_array result;
-    while (true) {
-        if (!skip_whitespace()) {
-            return invalid_value();
-        }
+    bool is_object() const noexcept { return _state.levels[_depth - 1].is_object; }
 
-        if constexpr (accept_jsonc) {
-            if (*_cur == ']') {
-                break;
-            }
+    void open(bool is_object)
+    {
+        auto& stack = _state.levels;
+        if (_depth == stack.size()) {
+            stack.emplace_back();
+        }
+        // an exception thrown by an earlier parse can leave children behind in the reused state
+        if (_depth == 0) {
+            _state.elements.clear();
         }
+        level& top = stack[_depth++];
+        top.is_object = is_object;
+        top.first_element = _state.elements.size();
+        top.members.clear();
+        top.key.clear();
+    }
 
-        value val = parse_value();
+    std::string& key() noexcept { return _state.levels[_depth - 1].key; }
 
-        if (!val.valid() || !skip_whitespace()) {
-            return invalid_value();
-        }
+    void add_key() noexcept {}
 
-        result.emplace_back(std::move(val));
+    bool add_scalar(parser& p)
+    {
+        value val = p.parse_value();
+        return val.valid() && add_to_top(std::move(val));
+    }
 
-        if (*_cur == ',') {
-            ++_cur;
+    bool close()
+    {
+        level& top = _state.levels[_depth - 1];
+        auto& elements = _state.elements;
+        value finished;
+        if (top.is_object) {
+            finished = std::move(top.members);
+            top.members.clear();
         }
         else {
-            break;
+            const auto first = elements.begin() + top.first_element;
+            auto arr = std::make_shared<array>();
+            arr->_array_data.assign(std::make_move_iterator(first), std::make_move_iterator(elements.end()));
+            elements.erase(first, elements.end());
+            finished = value(value::value_type::array, std::move(arr));
+        }
+
+        if (--_depth == 0) {
+            _result = std::move(finished);
+            trim_nesting(_state);
+            return true;
         }
+        return add_to_top(std::move(finished));
     }
 
-    if (skip_whitespace() && *_cur == ']') {
-        ++_cur;
+    // drops what the unfinished levels hold, leaving only their buffers
+    void fail()
+    {
+        for (size_t i = 0; i < _depth; ++i) {
+            _state.levels[i].members.clear();
+        }
+        _state.elements.clear();
+        trim_nesting(_state);
     }
-    else {
-        return invalid_value();
+
+    value& result() noexcept { return _result; }
+
+private:
+    // false for a duplicate key
+    bool add_to_top(value&& val)
+    {
+        level& top = _state.levels[_depth - 1];
+        if (!top.is_object) {
+            _state.elements.emplace_back(std::move(val));
+            return true;
+        }
+        return top.members.emplace(std::move(top.key), std::move(val)).second;
     }
 
-    return array(std::move(result));
-}
+    nesting& _state;
+    size_t _depth = 0;
+    value _result;
+};
 
+// Nodes appended to a frozen_value::builder, children before their parents
 template <bool accept_jsonc, typename parsing_t, typename accel_traits>
-inline value parser<accept_jsonc, parsing_t, accel_traits>::parse_object()
+class parser<accept_jsonc, parsing_t, accel_traits>::frozen_sink
 {
-    if (*_cur == '{') {
-        ++_cur;
-    }
-    else {
-        return invalid_value();
+public:
+    explicit frozen_sink(frozen_value::builder& build) noexcept
+        : _build(build)
+    {
     }
 
-    if (!skip_whitespace()) {
-        return invalid_value();
-    }
-    else if (*_cur == '}') {
-        ++_cur;
-        // empty object
-        return object();
-    }
+    size_t depth() const noexcept { return _stack.size(); }
 
-    typename object::raw_object result;
-    while (true) {
-        if (!skip_whitespace()) {
-            return invalid_value();
-        }
+    bool is_object() const noexcept { return _stack.back().is_object; }
 
-        if constexpr (accept_jsonc) {
-            if (*_cur == '}') {
-                break;
+    void open(bool is_object) { _stack.push_back(open_level { is_object, _build.pending.size() }); }
+
+    std::string& key() noexcept { return _text; }
+
+    void add_key() { _build.pending.emplace_back(_build.add_text(value::value_type::string, _text)); }
+
+    bool add_scalar(parser& p)
+    {
+        switch (*p._cur) {
+        case 'n':
+            if (!p.parse_null().valid()) {
+                return false;
+            }
+            _build.pending.emplace_back(_build.add_null());
+            return true;
+        case 't':
+        case 'f': {
+            value b = p.parse_boolean();
+            if (!b.valid()) {
+                return false;
             }
+            _build.pending.emplace_back(_build.add_boolean(b.as_boolean()));
+            return true;
         }
+        case '"':
+            _text.clear();
+            if (!p.parse_stdstring(_text)) {
+                return false;
+            }
+            _build.pending.emplace_back(_build.add_text(value::value_type::string, _text));
+            return true;
+        default: {
+            const auto first = p._cur;
+            if ((*p._cur != '-' && !std::isdigit(static_cast<unsigned char>(*p._cur))) || !p.skip_number()) {
+                return false;
+            }
+            _text.assign(first, p._cur);
+            _build.pending.emplace_back(_build.add_text(value::value_type::number, _text));
+            return true;
+        }
+        }
+    }
 
-        auto key_opt = parse_stdstring();
-
-        if (key_opt && skip_whitespace() && *_cur == ':') {
-            ++_cur;
+    // false for a duplicate key
+    bool close()
+    {
+        const open_level top = _stack.back();
+        uint32_t finished = 0;
+        if (top.is_object) {
+            auto closed = _build.close_object(top.first);
+            if (!closed) {
+                return false;
+            }
+            finished = *closed;
         }
         else {
-            return invalid_value();
+            finished = _build.close_array(top.first);
         }
 
-        if (!skip_whitespace()) {
-            return invalid_value();
+        _stack.pop_back();
+        if (_stack.empty()) {
+            _result = finished;
         }
+        else {
+            _build.pending.emplace_back(finished);
+        }
+        return true;
+    }
 
-        value val = parse_value();
+    // the builder is thrown away by the caller
+    void fail() noexcept {}
 
-        if (!val.valid() || !skip_whitespace()) {
-            return invalid_value();
-        }
+    uint32_t result() const noexcept { return _result; }
 
-        auto emplaced = result.emplace(std::move(*key_opt), std::move(val)).second;
-        if (!emplaced) {
-            return invalid_value();
-        }
+private:
+    struct open_level
+    {
+        bool is_object = false;
+        // where the children of this level start in builder::pending
+        size_t first = 0;
+    };
+
+    frozen_value::builder& _build;
+    std::vector<open_level> _stack;
+    std::string _text;
+    uint32_t _result = 0;
+};
 
-        if (*_cur == ',') {
+template <bool accept_jsonc, typename parsing_t, typename accel_traits>
+inline value parser<accept_jsonc, parsing_t, accel_traits>::parse_nested()
+{
+    value_sink sink(nesting_state());
+    if (!walk_nested(sink)) {
+        return invalid_value();
+    }
+    return std::move(sink.result());
+}
+
+template <bool accept_jsonc, typename parsing_t, typename accel_traits>
+template <typename sink_t>
+inline bool parser<accept_jsonc, parsing_t, accel_traits>::walk_nested(sink_t& sink)
+{
+    enum class step
+    {
+        open,    // _cur is at '[' or '{'
+        element, // after the opening bracket or a comma
+        separator,
+        close,
+    };
+
+    auto fail = [&]() {
+        sink.fail();
+        return false;
+    };
+
+    step next = step::open;
+    while (true) {
+        switch (next) {
+        case step::open: {
+            if (sink.depth() == _max_depth) {
+                return fail();
+            }
+            const bool is_object = *_cur == '{';
+            sink.open(is_object);
             ++_cur;
+
+            if (!skip_whitespace()) {
+                return fail();
+            }
+            // empty array or object
+            next = *_cur == (is_object ? '}' : ']') ? step::close : step::element;
+            break;
         }
-        else {
+        case step::element: {
+            const bool is_object = sink.is_object();
+            if (!skip_whitespace()) {
+                return fail();
+            }
+
+            if constexpr (accept_jsonc) {
+                if (*_cur == (is_object ? '}' : ']')) {
+                    next = step::close;
+                    break;
+                }
+            }
+
+            if (is_object) {
+                std::string& key = sink.key();
+                key.clear();
+                if (parse_stdstring(key) && skip_whitespace() && *_cur == ':') {
+                    ++_cur;
+                }
+                else {
+                    return fail();
+                }
+                sink.add_key();
+
+                if (!skip_whitespace()) {
+                    return fail();
+                }
+            }
+
+            if (*_cur == '[' || *_cur == '{') {
+                next = step::open;
+                break;
+            }
+
+            if (!sink.add_scalar(*this)) {
+                return fail();
+            }
+            next = step::separator;
+            break;
+        }
+        case step::separator:
+            if (!skip_whitespace()) {
+                return fail();
+            }
+            if (*_cur == ',') {
+                ++_cur;
+                next = step::element;
+            }
+            else {
+                next = step::close;
+            }
+            break;
+        case step::close:
+            if (skip_whitespace() && *_cur == (sink.is_object() ? '}' : ']')) {
+                ++_cur;
+            }
+            else {
+                return fail();
+            }
+
+            if (!sink.close()) {
+                return fail();
+            }
+            if (sink.depth() == 0) {
+                return true;
+            }
+            next = step::separator;
             break;
         }
     }
+}
 
-    if (skip_whitespace() && *_cur == '}') {
-        ++_cur;
+template <bool accept_jsonc, typename parsing_t, typename accel_traits>
+inline std::optional<frozen_value>
+    parser<accept_jsonc, parsing_t, accel_traits>::parse_frozen(const parsing_t& content, size_t max_depth)
+{
+    parser<accept_jsonc, parsing_t, accel_traits> p(content.cbegin(), content.cend(), max_depth);
+    // A JSON payload should be an object or array
+    if (!p.skip_whitespace() || (*p._cur != '[' && *p._cur != '{')) {
+        return std::nullopt;
     }
-    else {
-        return invalid_value();
+
+    frozen_value::builder build;
+    uint32_t root = 0;
+    if (!p.parse_frozen_nested(build, root) || p.skip_whitespace()) {
+        return std::nullopt;
     }
+    return build.finish(root);
+}
 
-    return object(std::move(result));
+template <bool accept_jsonc, typename parsing_t, typename accel_traits>
+inline bool parser<accept_jsonc, parsing_t, accel_traits>::parse_frozen_nested(frozen_value::builder& build, uint32_t& result)
+{
+    frozen_sink sink(build);
+    if (!walk_nested(sink)) {
+        return false;
+    }
+    result = sink.result();
+    return true;
 }
 
 template <bool accept_jsonc, typename parsing_t, typename accel_traits>
 inline std::optional<std::string> parser<accept_jsonc, parsing_t, accel_traits>::parse_stdstring()
+{
+    std::string result;
+    if (!parse_stdstring(result)) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+template <bool accept_jsonc, typename parsing_t, typename accel_traits>
+inline bool parser<accept_jsonc, parsing_t, accel_traits>::parse_stdstring(std::string& result)
 {
     if (*_cur == '"') {
         ++_cur;
     }
     else {
-        return std::nullopt;
+        return false;
     }
 
-    std::string result;
     auto no_escape_beg = _cur;
     uint16_t pair_high = 0;
 
     while (_cur != _end) {
         if constexpr (sizeof(*_cur) == 1 && accel_traits::available) {
             if (!skip_string_literal_with_accel()) {
-                return std::nullopt;
+                return false;
             }
         }
         switch (*_cur) {
         case '\t':
         case '\r':
         case '\n':
-            return std::nullopt;
+            return false;
         case '\\': {
             result.append(no_escape_beg, _cur++);
             if (_cur == _end) {
-                return std::nullopt;
+                return false;
             }
             if (pair_high && *_cur != 'u') {
-                return std::nullopt;
+                return false;
             }
             switch (*_cur) {
             case '"':
@@ -360,35 +603,35 @@ inline std::optional<std::string> parser<accept_jsonc, parsing_t, accel_traits>:
                 break;
             case 'u':
                 if (!skip_unicode_escape(pair_high, result)) {
-                    return std::nullopt;
+                    return false;
                 }
                 break;
             default:
                 // Illegal backslash escape
-                return std::nullopt;
+                return false;
             }
             no_escape_beg = ++_cur;
             break;
         }
         case '"': {
             if (pair_high) {
-                return std::nullopt;
+                return false;
             }
             result.append(no_escape_beg, _cur++);
-            return result;
+            return true;
         }
         default:
             if (pair_high) {
-                return std::nullopt;
+                return false;
             }
             if (static_cast<unsigned char>(*_cur) < 0x20) {
-                return std::nullopt;
+                return false;
             }
             ++_cur;
             break;
         }
     }
-    return std::nullopt;
+    return false;
 }
 
 template <bool accept_jsonc, typename parsing_t, typename accel_traits>
@@ -592,19 +835,363 @@ inline bool parser<accept_jsonc, parsing_t, accel_traits>::skip_digit()
     }
 }
 
+// ******************************
+// *      text reader impl      *
+// ******************************
+
+namespace _jsonization_helper
+{
+template <typename T>
+inline bool text_reader::read_document(T& out)
+{
+    if (!_parser.skip_whitespace()) {
+        return false;
+    }
+    if (!read(out)) {
+        return false;
+    }
+    // After the parsing is complete, there should be no more content other than spaces behind
+    return !_parser.skip_whitespace();
+}
+
+template <typename T>
+inline bool text_reader::read(T& out)
+{
+    if constexpr (_utils::has_from_json_text_in_member<T>::value) {
+        return out.from_json_text(*this);
+    }
+    else if constexpr (
+        _utils::is_json_value<T> || _utils::has_from_json_in_member<T>::value || _utils::has_from_json_in_templ_spec<T>::value) {
+        return read_through_value(out);
+    }
+    else if constexpr (std::is_same_v<T, bool>) {
+        if (read_literal(_utils::true_string())) {
+            out = true;
+            return true;
+        }
+        if (read_literal(_utils::false_string())) {
+            out = false;
+            return true;
+        }
+        return false;
+    }
+    else if constexpr (std::is_arithmetic_v<T>) {
+        return read_number(out);
+    }
+    else if constexpr (std::is_same_v<T, std::string>) {
+        out.clear();
+        return _parser.parse_stdstring(out);
+    }
+    else if constexpr (_utils::is_std_optional<T>) {
+        if (read_literal(_utils::null_string())) {
+            out.reset();
+            return true;
+        }
+        return read(out.emplace());
+    }
+    else if constexpr (_utils::is_collection<T> && _utils::has_emplace_back<T>::value) {
+        return read_sequence(out);
+    }
+    else if constexpr (_utils::is_map<T>) {
+        if constexpr (std::is_same_v<typename T::key_type, std::string>) {
+            return read_map(out);
+        }
+        else {
+            return read_through_value(out);
+        }
+    }
+    else {
+        return read_through_value(out);
+    }
+}
+
+template <typename func_t>
+inline bool text_reader::read_object(func_t&& on_member)
+{
+    if (_depth == _parser._max_depth) {
+        return false;
+    }
+    ++_depth;
+    const bool result = read_members(on_member);
+    --_depth;
+    return result;
+}
+
+template <typename func_t>
+inline bool text_reader::read_members(func_t& on_member)
+{
+    auto& cur = _parser._cur;
+    if (*cur == '{') {
+        ++cur;
+    }
+    else {
+        return false;
+    }
+
+    if (!_parser.skip_whitespace()) {
+        return false;
+    }
+    else if (*cur == '}') {
+        ++cur;
+        // empty object
+        return true;
+    }
+
+    while (true) {
+        if (!_parser.skip_whitespace()) {
+            return false;
+        }
+
+        _key.clear();
+        if (_parser.parse_stdstring(_key) && _parser.skip_whitespace() && *cur == ':') {
+            ++cur;
+        }
+        else {
+            return false;
+        }
+
+        // _key may be overwritten by nested objects once on_member has found the member
+        if (!_parser.skip_whitespace() || !on_member(std::string_view(_key)) || !_parser.skip_whitespace()) {
+            return false;
+        }
+
+        if (*cur == ',') {
+            ++cur;
+        }
+        else {
+            break;
+        }
+    }
+
+    if (_parser.skip_whitespace() && *cur == '}') {
+        ++cur;
+        return true;
+    }
+    return false;
+}
+
+inline bool text_reader::skip_value()
+{
+    auto& cur = _parser._cur;
+    // closing brackets of the arrays and objects being skipped, innermost last
+    _closers.clear();
+    // key, colon and whitespace up to the member value
+    auto skip_key = [&]() {
+        _scratch.clear();
+        if (!_parser.parse_stdstring(_scratch) || !_parser.skip_whitespace() || *cur != ':') {
+            return false;
+        }
+        ++cur;
+        return _parser.skip_whitespace();
+    };
+
+    while (true) {
+        // cur is at a value
+        switch (*cur) {
+        case 'n':
+            if (!read_literal(_utils::null_string())) {
+                return false;
+            }
+            break;
+        case 't':
+            if (!read_literal(_utils::true_string())) {
+                return false;
+            }
+            break;
+        case 'f':
+            if (!read_literal(_utils::false_string())) {
+                return false;
+            }
+            break;
+        case '"':
+            _scratch.clear();
+            if (!_parser.parse_stdstring(_scratch)) {
+                return false;
+            }
+            break;
+        case '[':
+        case '{': {
+            if (_depth + _closers.size() >= _parser._max_depth) {
+                return false;
+            }
+            const char closer = *cur == '[' ? ']' : '}';
+            ++cur;
+            if (!_parser.skip_whitespace()) {
+                return false;
+            }
+            if (*cur == closer) {
+                // empty array or object
+                ++cur;
+                break;
+            }
+            _closers.push_back(closer);
+            if (closer == '}' && !skip_key()) {
+                return false;
+            }
+            continue;
+        }
+        default:
+            if (!_parser.skip_number()) {
+                return false;
+            }
+            break;
+        }
+
+        // a value is complete: close the levels it ends, then go on with the next element
+        while (true) {
+            if (_closers.empty()) {
+                return true;
+            }
+            if (!_parser.skip_whitespace()) {
+                return false;
+            }
+            if (*cur == _closers.back()) {
+                ++cur;
+                _closers.pop_back();
+                continue;
+            }
+            if (*cur != ',') {
+                return false;
+            }
+            ++cur;
+            if (!_parser.skip_whitespace() || (_closers.back() == '}' && !skip_key())) {
+                return false;
+            }
+            break;
+        }
+    }
+}
+
+template <typename T>
+inline bool text_reader::read_number(T& out)
+{
+    const auto first = _parser._cur;
+    if (!_parser.skip_number()) {
+        return false;
+    }
+
+    if constexpr (std::is_integral_v<T>) {
+        const char* last = to_pointer(_parser._cur);
+        const auto [ptr, ec] = std::from_chars(to_pointer(first), last, out);
+        return ec == std::errc {} && ptr == last;
+    }
+    else {
+        _scratch.assign(first, _parser._cur);
+        return _value_impl_detail::try_parse_floating(_scratch, out);
+    }
+}
+
+template <typename T>
+inline bool text_reader::read_sequence(T& out)
+{
+    if (_depth == _parser._max_depth) {
+        return false;
+    }
+    ++_depth;
+    const bool result = read_elements(out);
+    --_depth;
+    return result;
+}
+
+template <typename T>
+inline bool text_reader::read_elements(T& out)
+{
+    auto& cur = _parser._cur;
+    if (*cur == '[') {
+        ++cur;
+    }
+    else {
+        return false;
+    }
+
+    out.clear();
+    if (!_parser.skip_whitespace()) {
+        return false;
+    }
+    else if (*cur == ']') {
+        ++cur;
+        // empty array
+        return true;
+    }
+
+    while (true) {
+        if (!_parser.skip_whitespace() || !read(out.emplace_back()) || !_parser.skip_whitespace()) {
+            return false;
+        }
+
+        if (*cur == ',') {
+            ++cur;
+        }
+        else {
+            break;
+        }
+    }
+
+    if (_parser.skip_whitespace() && *cur == ']') {
+        ++cur;
+        return true;
+    }
+    return false;
+}
+
+template <typename T>
+inline bool text_reader::read_map(T& out)
+{
+    out.clear();
+    return read_object([&](std::string_view key) {
+        auto [iter, inserted] = out.try_emplace(std::string(key));
+        return inserted && read(iter->second);
+    });
+}
+
+template <typename T>
+inline bool text_reader::read_through_value(T& out)
+{
+    // the subtree only gets the nesting left over from the levels above it
+    const size_t max_depth = _parser._max_depth;
+    _parser._max_depth = max_depth - _depth;
+    value val = _parser.parse_value();
+    _parser._max_depth = max_depth;
+    if (!val.valid()) {
+        return false;
+    }
+    if constexpr (std::is_same_v<T, value>) {
+        out = std::move(val);
+    }
+    else {
+        auto converted = val.try_as<T>();
+        if (!converted) {
+            return false;
+        }
+        out = std::move(*converted);
+    }
+    return true;
+}
+
+inline bool text_reader::read_literal(std::string_view literal)
+{
+    auto& cur = _parser._cur;
+    if (static_cast<size_t>(_parser._end - cur) < literal.size() || std::string_view(to_pointer(cur), literal.size()) != literal) {
+        return false;
+    }
+    cur += literal.size();
+    return true;
+}
+} // namespace _jsonization_helper
+
 // *************************
 // *      utils impl       *
 // *************************
 
 template <typename parsing_t>
-inline std::optional<value> parse(const parsing_t& content)
+inline std::optional<value> parse(const parsing_t& content, size_t max_depth)
 {
-    return parser<false, parsing_t>::parse(content);
+    return parser<false, parsing_t>::parse(content, max_depth);
 }
 
-inline std::optional<value> parse(const char* content)
+inline std::optional<value> parse(const char* content, size_t max_depth)
 {
-    return parse(std::string_view { content });
+    return parse(std::string_view { content }, max_depth);
 }
 
 inline std::optional<value> parse(std::istream& istream, bool check_bom, bool with_commets)
@@ -643,15 +1230,44 @@ inline std::optional<value> open(const path_t& filepath, bool check_bom, bool wi
     return opt;
 }
 
+template <typename T>
+inline bool parse_into(std::string_view content, T& out)
+{
+    std::string error_key;
+    return parse_into(content, out, error_key);
+}
+
+template <typename T>
+inline bool parse_into(std::string_view content, T& out, std::string& error_key)
+{
+    _jsonization_helper::text_reader reader(content);
+    if (reader.read_document(out)) {
+        return true;
+    }
+    error_key = reader.error_key();
+    return false;
+}
+
+template <typename parsing_t>
+inline std::optional<frozen_value> parse_frozen(const parsing_t& content, size_t max_depth)
+{
+    return parser<false, parsing_t>::parse_frozen(content, max_depth);
+}
+
+inline std::optional<frozen_value> parse_frozen(const char* content, size_t max_depth)
+{
+    return parse_frozen(std::string_view { content }, max_depth);
+}
+
 template <typename parsing_t>
-inline std::optional<value> parsec(const parsing_t& content)
+inline std::optional<value> parsec(const parsing_t& content, size_t max_depth)
 {
-    return parser<true, parsing_t>::parse(content);
+    return parser<true, parsing_t>::parse(content, max_depth);
 }
 
-inline std::optional<value> parsec(const char* content)
+inline std::optional<value> parsec(const char* content, size_t max_depth)
 {
-    return parsec(std::string_view { content });
+    return parsec(std::string_view { content }, max_depth);
 }
 
 namespace literals
@@ -2,11 +2,21 @@
 
 #pragma once
 
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <ostream>
 #include <string>
+#include <string_view>
+#include <tuple>
 #include <type_traits>
 #include <utility>
+#include <variant>
+#include <vector>
 
 #include "../common/types.hpp"
+#include "../parser/bitops.hpp"
+#include "../parser/parser.hpp"
 
 namespace json::_jsonization_helper
 {
@@ -81,6 +91,206 @@ struct dumper
     }
 };
 
+template <typename T, typename after_elem_t>
+void dump_json_sequence(std::string& out, const T& val, after_elem_t&& after_elem);
+
+// Writes val as compact JSON text. MEO_TOJSON types, containers and scalars are written directly;
+// anything else goes through json::value.
+template <typename T>
+inline void dump_json_to(std::string& out, const T& val)
+{
+    if constexpr (_utils::is_json_value<T>) {
+        val.dump_to(out);
+    }
+    else if constexpr (_utils::has_dump_json_in_member<T>::value) {
+        val.dump_json_to(out);
+    }
+    else if constexpr (_utils::has_dump_json_in_templ_spec<T>::value) {
+        ext::jsonization<T>().dump_json_to(val, out);
+    }
+    else if constexpr (_utils::has_to_json_in_member<T>::value || _utils::has_to_json_in_templ_spec<T>::value) {
+        value(val).dump_to(out);
+    }
+    else if constexpr (std::is_same_v<T, bool>) {
+        out.append(val ? _utils::true_string() : _utils::false_string());
+    }
+    else if constexpr (std::is_same_v<T, std::nullptr_t> || std::is_same_v<T, std::monostate>) {
+        out.append(_utils::null_string());
+    }
+    else if constexpr (std::is_integral_v<T>) {
+        // same digits as std::to_string, used by json::value
+        using wide_t = std::conditional_t<std::is_signed_v<T>, long long, unsigned long long>;
+        char buf[24];
+        const auto result = std::to_chars(buf, buf + sizeof(buf), static_cast<wide_t>(val));
+        out.append(buf, static_cast<size_t>(result.ptr - buf));
+    }
+    else if constexpr (std::is_floating_point_v<T>) {
+        out.append(_utils::to_basic_string(val));
+    }
+    else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        out.push_back('"');
+        _utils::append_escaped_string(out, std::string_view(val));
+        out.push_back('"');
+    }
+    else if constexpr (_utils::is_nullable<T>) {
+        if (val) {
+            dump_json_to(out, *val);
+        }
+        else {
+            out.append(_utils::null_string());
+        }
+    }
+    else if constexpr (_utils::is_variant<T>) {
+        std::visit([&](const auto& alt) { dump_json_to(out, alt); }, val);
+    }
+    else if constexpr (_utils::is_map<T>) {
+        if constexpr (std::is_same_v<typename T::key_type, std::string>) {
+            out.push_back('{');
+            for (const auto& [key, elem] : val) {
+                out.push_back('"');
+                _utils::append_escaped_string(out, key);
+                out.push_back('"');
+                out.push_back(':');
+                dump_json_to(out, elem);
+                out.push_back(',');
+            }
+            if (out.back() == ',') {
+                out.back() = '}';
+            }
+            else {
+                out.push_back('}');
+            }
+        }
+        else {
+            value(val).dump_to(out);
+        }
+    }
+    else if constexpr (_utils::is_collection<T> || _utils::is_fixed_array<T>) {
+        if constexpr (_utils::has_dump_json_in_member<typename T::value_type>::value && _utils::has_size<T>::value) {
+            // records of one reflected type come out at about the same size,
+            // so the first one is enough to size the output for the rest.
+            // Only grow geometrically: nested sequences share the output, and libc++ reserves exactly.
+            dump_json_sequence(out, val, [&](std::string& text, size_t index, size_t written) {
+                if (index != 0) {
+                    return;
+                }
+                const size_t wanted = text.size() + (written + written / 8 + 1) * (val.size() - 1) + 1;
+                if (wanted > text.capacity()) {
+                    text.reserve(std::max(wanted, 2 * text.capacity()));
+                }
+            });
+        }
+        else {
+            dump_json_sequence(out, val, [](std::string&, size_t, size_t) {});
+        }
+    }
+    else if constexpr (_utils::is_tuple_like<T>) {
+        out.push_back('[');
+        std::apply([&](const auto&... elems) { ((dump_json_to(out, elems), out.push_back(',')), ...); }, val);
+        if (out.back() == ',') {
+            out.back() = ']';
+        }
+        else {
+            out.push_back(']');
+        }
+    }
+    else {
+        value(val).dump_to(out);
+    }
+}
+
+// Writes the elements of a collection as a JSON array, calling after_elem(out, index, bytes written) after each one
+template <typename T, typename after_elem_t>
+inline void dump_json_sequence(std::string& out, const T& val, after_elem_t&& after_elem)
+{
+    out.push_back('[');
+    size_t index = 0;
+    for (const auto& elem : val) {
+        if (index) {
+            out.push_back(',');
+        }
+        const size_t start = out.size();
+        dump_json_to(out, elem);
+        after_elem(out, index++, out.size() - start);
+    }
+    out.push_back(']');
+}
+
+// Escaped key text of a MEO_TOJSON list: {"a": for the first field, then ,"b": and so on, closed by }.
+// Built once per type, so writing a record appends one prefix per field instead of escaping every key again.
+class field_keys
+{
+public:
+    template <typename... args_t>
+    explicit field_keys(const args_t&... args)
+    {
+        _collect(next_state_t {}, args...);
+        _text.append(_ends.empty() ? "{}" : "}");
+        _ends.emplace_back(_text.size());
+    }
+
+    size_t size() const noexcept { return _ends.size() - 1; }
+
+    // the last prefix (i == size()) closes the object
+    std::string_view prefix(size_t i) const noexcept
+    {
+        const size_t begin = i ? _ends[i - 1] : 0;
+        return std::string_view(_text).substr(begin, _ends[i] - begin);
+    }
+
+private:
+    void _collect(next_state_t, va_arg_end) {}
+
+    template <typename var_t, typename... rest_t, typename _ = std::enable_if_t<!is_tag_t<var_t>::value, void>>
+    void _collect(next_state_t state, const char* key, const var_t&, const rest_t&... rest)
+    {
+        _text.push_back(_ends.empty() ? '{' : ',');
+        _text.push_back('"');
+        _utils::append_escaped_string(_text, std::string_view(state.override_key ? state.override_key : key));
+        _text.push_back('"');
+        _text.push_back(':');
+        _ends.emplace_back(_text.size());
+        _collect(next_state_t {}, rest...);
+    }
+
+    template <typename... rest_t>
+    void _collect(next_state_t state, const char*, next_is_optional_t, const rest_t&... rest)
+    {
+        state.is_optional = true;
+        _collect(state, rest...);
+    }
+
+    template <typename... rest_t>
+    void _collect(next_state_t state, const char*, next_override_key_t override_key, const rest_t&... rest)
+    {
+        state.override_key = override_key.key;
+        _collect(state, rest...);
+    }
+
+    std::string _text;
+    std::vector<size_t> _ends;
+};
+
+// Same field list as dumper, but appends the prefixes of field_keys and the values straight to the output text
+struct text_dumper
+{
+    void _dump_json(std::string& out, const field_keys& keys, size_t i, va_arg_end) const { out.append(keys.prefix(i)); }
+
+    template <typename var_t, typename... rest_t, typename _ = std::enable_if_t<!is_tag_t<var_t>::value, void>>
+    void _dump_json(std::string& out, const field_keys& keys, size_t i, const char*, const var_t& var, rest_t&&... rest) const
+    {
+        out.append(keys.prefix(i));
+        dump_json_to(out, var);
+        _dump_json(out, keys, i + 1, std::forward<rest_t>(rest)...);
+    }
+
+    template <typename tag_t, typename... rest_t, typename _ = std::enable_if_t<is_tag_t<tag_t>::value, void>>
+    void _dump_json(std::string& out, const field_keys& keys, size_t i, const char*, tag_t, rest_t&&... rest) const
+    {
+        _dump_json(out, keys, i, std::forward<rest_t>(rest)...);
+    }
+};
+
 struct checker
 {
     bool _check_json(const value&, std::string&, va_arg_end) const { return true; }
@@ -137,65 +347,248 @@ struct checker
     }
 };
 
-struct loader
+// Field names of a MEO_FROMJSON list (after MEO_KEY), with an open-addressing table from key to field index,
+// so a member key is matched with one hash and usually a single string comparison.
+// The list refers to data members, so the table is built once per type on first use rather than at compile time.
+class field_index
 {
-    bool _from_json(const value&, std::string&, va_arg_end) const { return true; }
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
 
-    template <typename... rest_t>
-    bool _from_json(const value& in, std::string& error_key, const char* key, rest_t&&... rest)
+    template <typename... args_t>
+    explicit field_index(const args_t&... args)
     {
-        return _from_json(in, error_key, next_state_t {}, key, std::forward<rest_t>(rest)...);
-    }
+        _collect(next_state_t {}, args...);
 
-    template <typename var_t, typename... rest_t, typename _ = std::enable_if_t<!is_tag_t<var_t>::value, void>>
-    bool _from_json(const value& in, std::string& error_key, next_state_t state, const char* key, var_t& var, rest_t&&... rest)
-    {
-        if (state.override_key) {
-            key = state.override_key;
+        size_t capacity = 4;
+        while (capacity < _names.size() * 2) {
+            capacity *= 2;
         }
-        const value* val = in.find_value(key);
-        if (val) {
-            if (val->is<var_t>()) {
-                var = val->as<var_t>();
-            }
-            else {
-                error_key = key;
-                return false;
+        _slots.assign(capacity, 0);
+        for (size_t i = 0; i < _names.size(); ++i) {
+            size_t slot = hash(_names[i]) & (capacity - 1);
+            while (_slots[slot]) {
+                slot = (slot + 1) & (capacity - 1);
             }
+            // 0 marks an empty slot
+            _slots[slot] = static_cast<uint8_t>(i + 1);
         }
-        else if (state.is_optional) {
-            // is_optional, ignore key not found
+    }
+
+    size_t find(std::string_view key) const noexcept
+    {
+        const size_t mask = _slots.size() - 1;
+        for (size_t slot = hash(key) & mask; _slots[slot]; slot = (slot + 1) & mask) {
+            const size_t i = _slots[slot] - 1;
+            if (_names[i] == key) {
+                return i;
+            }
         }
-        else {
-            error_key = key;
-            return false;
+        return npos;
+    }
+
+    std::string_view name(size_t i) const noexcept { return _names[i]; }
+
+    // lowest index of a required field whose bit is not set in loaded
+    size_t first_missing(uint64_t loaded) const noexcept
+    {
+        const uint64_t missing = _required & ~loaded;
+        return missing ? static_cast<size_t>(_bitops::countr_zero(missing)) : npos;
+    }
+
+private:
+    static size_t hash(std::string_view key) noexcept
+    {
+        if (key.empty()) {
+            return 0;
         }
+        // length and three sampled characters tell typical field names apart; collisions are resolved by probing
+        const auto ch = [&](size_t pos) { return static_cast<size_t>(static_cast<unsigned char>(key[pos])); };
+        return key.size() * 31 + ch(0) * 7 + ch(key.size() / 2) * 131 + ch(key.size() - 1);
+    }
+
+    void _collect(next_state_t, va_arg_end) {}
 
-        return _from_json(in, error_key, std::forward<rest_t>(rest)...);
+    template <typename var_t, typename... rest_t, typename _ = std::enable_if_t<!is_tag_t<var_t>::value, void>>
+    void _collect(next_state_t state, const char* key, const var_t&, const rest_t&... rest)
+    {
+        if (!state.is_optional) {
+            _required |= uint64_t(1) << _names.size();
+        }
+        _names.emplace_back(state.override_key ? state.override_key : key);
+        _collect(next_state_t {}, rest...);
     }
 
     template <typename... rest_t>
-    bool _from_json(const value& in, std::string& error_key, next_state_t state, const char*, next_is_optional_t, rest_t&&... rest)
+    void _collect(next_state_t state, const char*, next_is_optional_t, const rest_t&... rest)
     {
         state.is_optional = true;
-        return _from_json(in, error_key, state, std::forward<rest_t>(rest)...);
+        _collect(state, rest...);
     }
 
     template <typename... rest_t>
-    bool _from_json(
-        const value& in,
-        std::string& error_key,
-        next_state_t state,
-        const char*,
-        next_override_key_t override_key,
-        rest_t&&... rest)
+    void _collect(next_state_t state, const char*, next_override_key_t override_key, const rest_t&... rest)
     {
         state.override_key = override_key.key;
-        return _from_json(in, error_key, state, std::forward<rest_t>(rest)...);
+        _collect(state, rest...);
+    }
+
+    std::vector<std::string_view> _names;
+    std::vector<uint8_t> _slots;
+    uint64_t _required = 0;
+};
+
+// Calls func(var) for the field with the given index
+template <typename func_t>
+inline bool visit_field(size_t, size_t, func_t&, va_arg_end)
+{
+    return false;
+}
+
+template <
+    typename func_t,
+    typename var_t,
+    typename... rest_t,
+    typename _ = std::enable_if_t<!is_tag_t<var_t>::value, void>>
+inline bool visit_field(size_t target, size_t index, func_t& func, const char*, var_t& var, rest_t&... rest)
+{
+    if (index == target) {
+        return func(var);
+    }
+    return visit_field(target, index + 1, func, rest...);
+}
+
+template <typename func_t, typename... rest_t>
+inline bool visit_field(size_t target, size_t index, func_t& func, const char*, next_is_optional_t, rest_t&... rest)
+{
+    return visit_field(target, index, func, rest...);
+}
+
+template <typename func_t, typename... rest_t>
+inline bool visit_field(size_t target, size_t index, func_t& func, const char*, next_override_key_t, rest_t&... rest)
+{
+    return visit_field(target, index, func, rest...);
+}
+
+struct loader
+{
+    // in_t is const value& or value; for the latter, strings and containers are moved out of the members
+    template <typename in_t, typename... args_t>
+    bool _from_json(in_t&& in, std::string& error_key, const field_index& index, args_t&&... args) const
+    {
+        // MEO_FROMJSON takes at most 64 fields, so one bit per field is enough
+        uint64_t loaded = 0;
+        if (in.is_object()) {
+            for (auto& [key, val] : in.as_object()) {
+                const size_t i = index.find(key);
+                if (i == field_index::npos) {
+                    continue;
+                }
+                auto load = [&](auto& var) {
+                    // checked and converted in one pass, nested reflected types included
+                    auto converted = std::forward<in_t>(val).template try_as<std::decay_t<decltype(var)>>();
+                    if (!converted) {
+                        return false;
+                    }
+                    var = std::move(*converted);
+                    return true;
+                };
+                if (!visit_field(i, 0, load, args...)) {
+                    error_key = index.name(i);
+                    _utils::prepend_failure(&in, &val, key, [&] { return val.value_info(); });
+                    return false;
+                }
+                loaded |= uint64_t(1) << i;
+            }
+        }
+
+        if (const size_t i = index.first_missing(loaded); i != field_index::npos) {
+            error_key = index.name(i);
+            _utils::prepend_failure(&in, nullptr, error_key, [] { return std::string("missing required field"); });
+            return false;
+        }
+        return true;
+    }
+};
+
+// Same as loader, but members are matched while json::parse_into reads the object text
+struct text_loader
+{
+    template <typename... args_t>
+    bool _from_json_text(text_reader& in, const field_index& index, args_t&&... args) const
+    {
+        uint64_t loaded = 0;
+        bool read = in.read_object([&](std::string_view key) {
+            const size_t i = index.find(key);
+            if (i == field_index::npos) {
+                return in.skip_value();
+            }
+            const uint64_t bit = uint64_t(1) << i;
+            auto load = [&](auto& var) { return in.read(var); };
+            // duplicate keys are rejected like json::parse does
+            if ((loaded & bit) || !visit_field(i, 0, load, args...)) {
+                in.set_error_key(index.name(i));
+                return false;
+            }
+            loaded |= bit;
+            return true;
+        });
+        if (!read) {
+            return false;
+        }
+
+        if (const size_t i = index.first_missing(loaded); i != field_index::npos) {
+            in.set_error_key(index.name(i));
+            return false;
+        }
+        return true;
     }
 };
 } // namespace json::_jsonization_helper
 
+namespace json
+{
+// Serializes val to compact JSON without building a json::value for MEO_TOJSON types, containers and scalars.
+// Members of MEO_TOJSON types are written in declaration order rather than sorted by key.
+template <typename T>
+inline void serialize_to(std::string& out, const T& val)
+{
+    _jsonization_helper::dump_json_to(out, val);
+}
+
+template <typename T>
+inline std::string serialize(const T& val)
+{
+    std::string result;
+    _jsonization_helper::dump_json_to(result, val);
+    return result;
+}
+
+// Streams val to os. Collections are written in chunks of about chunk_size bytes,
+// so exporting a large vector of records never holds the whole text in memory.
+template <typename T>
+inline void serialize_to(std::ostream& os, const T& val, size_t chunk_size = 64 * 1024)
+{
+    std::string buffer;
+    buffer.reserve(chunk_size + chunk_size / 4);
+    if constexpr (
+        (_utils::is_collection<T> || _utils::is_fixed_array<T>) && !_utils::has_dump_json_in_member<T>::value
+        && !_utils::has_dump_json_in_templ_spec<T>::value && !_utils::has_to_json_in_member<T>::value
+        && !_utils::has_to_json_in_templ_spec<T>::value && !_utils::is_json_value<T>) {
+        _jsonization_helper::dump_json_sequence(buffer, val, [&](std::string& text, size_t, size_t) {
+            if (text.size() >= chunk_size) {
+                os.write(text.data(), static_cast<std::streamsize>(text.size()));
+                text.clear();
+            }
+        });
+    }
+    else {
+        _jsonization_helper::dump_json_to(buffer, val);
+    }
+    os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+} // namespace json
+
 #if defined(__clang__)
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wgnu-zero-variadic-macro-arguments"
@@ -433,6 +826,20 @@ namespace json::_private_macro
             result,                                                                                                        \
             _MEOJSON_EXPAND(_MEOJSON_FOR_EACH(_MEOJSON_KEY_VALUE, __VA_ARGS__)) json::_jsonization_helper::va_arg_end {}); \
         return result;                                                                                                     \
+    }                                                                                                                      \
+    void dump_json_to(std::string& _MEOJSON_VARNAME(out)) const                                                            \
+    {                                                                                                                      \
+        json::_jsonization_helper::text_dumper()._dump_json(                                                               \
+            _MEOJSON_VARNAME(out),                                                                                         \
+            _MEOJSON_VARNAME(field_keys)(),                                                                                \
+            0,                                                                                                             \
+            _MEOJSON_EXPAND(_MEOJSON_FOR_EACH(_MEOJSON_KEY_VALUE, __VA_ARGS__)) json::_jsonization_helper::va_arg_end {}); \
+    }                                                                                                                      \
+    const json::_jsonization_helper::field_keys& _MEOJSON_VARNAME(field_keys)() const                                      \
+    {                                                                                                                      \
+        static const json::_jsonization_helper::field_keys _MEOJSON_VARNAME(keys)(                                         \
+            _MEOJSON_EXPAND(_MEOJSON_FOR_EACH(_MEOJSON_KEY_VALUE, __VA_ARGS__)) json::_jsonization_helper::va_arg_end {}); \
+        return _MEOJSON_VARNAME(keys);                                                                                     \
     }
 
 #define MEO_CHECKJSON(...)                                                                                                 \
@@ -460,7 +867,34 @@ namespace json::_private_macro
         return json::_jsonization_helper::loader()._from_json(                                                             \
             _MEOJSON_VARNAME(in),                                                                                          \
             _MEOJSON_VARNAME(error_key),                                                                                   \
+            _MEOJSON_VARNAME(field_index)(),                                                                               \
+            _MEOJSON_EXPAND(_MEOJSON_FOR_EACH(_MEOJSON_KEY_VALUE, __VA_ARGS__)) json::_jsonization_helper::va_arg_end {}); \
+    }                                                                                                                      \
+    bool from_json(json::value&& _MEOJSON_VARNAME(in))                                                                     \
+    {                                                                                                                      \
+        std::string _MEOJSON_VARNAME(error_key);                                                                           \
+        return from_json(std::move(_MEOJSON_VARNAME(in)), _MEOJSON_VARNAME(error_key));                                    \
+    }                                                                                                                      \
+    bool from_json(json::value&& _MEOJSON_VARNAME(in), std::string& _MEOJSON_VARNAME(error_key))                           \
+    {                                                                                                                      \
+        return json::_jsonization_helper::loader()._from_json(                                                             \
+            std::move(_MEOJSON_VARNAME(in)),                                                                               \
+            _MEOJSON_VARNAME(error_key),                                                                                   \
+            _MEOJSON_VARNAME(field_index)(),                                                                               \
+            _MEOJSON_EXPAND(_MEOJSON_FOR_EACH(_MEOJSON_KEY_VALUE, __VA_ARGS__)) json::_jsonization_helper::va_arg_end {}); \
+    }                                                                                                                      \
+    bool from_json_text(json::_jsonization_helper::text_reader& _MEOJSON_VARNAME(in))                                      \
+    {                                                                                                                      \
+        return json::_jsonization_helper::text_loader()._from_json_text(                                                   \
+            _MEOJSON_VARNAME(in),                                                                                          \
+            _MEOJSON_VARNAME(field_index)(),                                                                               \
+            _MEOJSON_EXPAND(_MEOJSON_FOR_EACH(_MEOJSON_KEY_VALUE, __VA_ARGS__)) json::_jsonization_helper::va_arg_end {}); \
+    }                                                                                                                      \
+    const json::_jsonization_helper::field_index& _MEOJSON_VARNAME(field_index)() const                                    \
+    {                                                                                                                      \
+        static const json::_jsonization_helper::field_index _MEOJSON_VARNAME(index)(                                       \
             _MEOJSON_EXPAND(_MEOJSON_FOR_EACH(_MEOJSON_KEY_VALUE, __VA_ARGS__)) json::_jsonization_helper::va_arg_end {}); \
+        return _MEOJSON_VARNAME(index);                                                                                    \
     }
 
 #define MEO_JSONIZATION(...)                    \
@@ -35,6 +35,25 @@ enum class Status
     MEOJSON_ENUM_RANGE(Idle, Stopped)
 };
 
+// Names that differ only in case
+enum class Mixed
+{
+    value,
+    Value,
+    other
+};
+
+// Sparse values that MEOJSON_ENUM_VALUES lists explicitly, outside the default reflected range
+enum class Code : int
+{
+    Ok = 0,
+    NotFound = 404,
+    Teapot = 418,
+    Internal = 500
+};
+
+MEOJSON_ENUM_VALUES(Code, Code::Internal, Code::Ok, Code::NotFound, Code::Teapot);
+
 bool enum_test()
 {
     bool success = true;
@@ -220,5 +239,50 @@ bool enum_test()
         }
     }
 
+    // 8. Name tables hold only the valid enumerators
+    std::cout << "Testing enum name lookup..." << std::endl;
+    {
+        static_assert(json::_reflection::enum_lookup_storage<Color>::size == 3);
+        static_assert(json::_reflection::enum_lookup_storage<Status>::size == 4);
+
+        for (auto d : { Direction::Up, Direction::Down, Direction::Left, Direction::Right }) {
+            auto name = json::_reflection::enum_to_string(d);
+            if (json::_reflection::string_to_enum<Direction>(name) != d) {
+                std::cout << "Error: lookup of '" << name << "' failed" << std::endl;
+                success = false;
+            }
+        }
+        if (json::_reflection::string_to_enum<Direction>("Upp") || json::_reflection::string_to_enum<Direction>("")) {
+            std::cout << "Error: unknown Direction names should not be found" << std::endl;
+            success = false;
+        }
+
+        // case-insensitive lookup prefers the lowest value, the exact one matches case
+        if (json::_reflection::string_to_enum<Mixed>("VALUE") != Mixed::value
+            || json::_reflection::string_to_enum_exact<Mixed>("Value") != Mixed::Value
+            || json::_reflection::string_to_enum_exact<Mixed>("value") != Mixed::value
+            || json::_reflection::string_to_enum_exact<Mixed>("VALUE")) {
+            std::cout << "Error: case handling of Mixed names" << std::endl;
+            success = false;
+        }
+    }
+
+    // 9. Enumerators listed with MEOJSON_ENUM_VALUES
+    std::cout << "Testing MEOJSON_ENUM_VALUES macro..." << std::endl;
+    {
+        static_assert(json::_reflection::enum_lookup_storage<Code>::size == 4);
+
+        json::value v = Code::Teapot;
+        if (v.as_string() != "Teapot" || json::value("notfound").as<Code>() != Code::NotFound
+            || json::value(500).as<Code>() != Code::Internal) {
+            std::cout << "Error: Code conversions failed" << std::endl;
+            success = false;
+        }
+        if (!json::_reflection::enum_to_string(static_cast<Code>(1)).empty() || json::value("Unknown").is<Code>()) {
+            std::cout << "Error: unlisted Code values should not be found" << std::endl;
+            success = false;
+        }
+    }
+
     return success;
 }
@@ -25,6 +25,9 @@ int main()
     std::cout << "\n*** jsonizing ***\n" << std::endl;
     success &= jsonizing();
 
+    std::cout << "\n*** canonicalizing ***\n" << std::endl;
+    success &= canonicalizing();
+
     std::cout << "\n*** include_test ***\n" << std::endl;
     success &= include_test();
 
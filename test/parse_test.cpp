@@ -1,4 +1,7 @@
 #include <iostream>
+#include <map>
+#include <optional>
+#include <vector>
 
 #include "json.hpp"
 #include "parse_test.h"
@@ -8,10 +11,13 @@ bool wrong_json();
 bool jsonc_trail_comma();
 bool jsonc_comment();
 bool string_control_characters();
+bool parse_into_struct();
+bool nesting_depth();
 
 bool parsing()
 {
-    return normal_json() && wrong_json() && jsonc_trail_comma() && jsonc_comment() && string_control_characters();
+    return normal_json() && wrong_json() && jsonc_trail_comma() && jsonc_comment() && string_control_characters() && parse_into_struct()
+           && nesting_depth();
 }
 
 bool normal_json()
@@ -111,6 +117,52 @@ bool string_control_characters()
     return true;
 }
 
+bool nesting_depth()
+{
+    constexpr size_t depth = 100000;
+    std::string deep = std::string(depth, '[') + std::string(depth, ']');
+    if (json::parse(deep)) {
+        std::cerr << "Parsing should stop at the default max depth" << std::endl;
+        return false;
+    }
+    auto deep_opt = json::parse(deep, depth);
+    if (!deep_opt || deep_opt->to_string() != deep) {
+        std::cerr << "Parsing failed at depth " << depth << std::endl;
+        return false;
+    }
+
+    std::string nested = R"({"a":[{"a":[1, 2]}], "b": {}})";
+    if (!json::parse(nested, 4) || json::parse(nested, 3) || !json::parsec(nested, 4) || json::parsec(nested, 3)) {
+        std::cerr << "Parsing should allow exactly max_depth levels:" << nested << std::endl;
+        return false;
+    }
+
+    // parse_into skips unknown members without recursing, but with the same limit
+    struct Flat
+    {
+        int a = 0;
+
+        MEO_JSONIZATION(a);
+    };
+    Flat flat;
+    const std::string deep_unknown = R"({"a":1,"x":)" + std::string(1000000, '[') + std::string(1000000, ']') + "}";
+    const std::string unknown = R"({"x":[{"k":[1,{},[]]},"s",null],"a":2,"y":{"z":{}}})";
+    if (json::parse_into(deep_unknown, flat) || !json::parse_into(unknown, flat) || flat.a != 2
+        || json::parse_into(R"({"a":1,"x":[{"k":[1,]}]})", flat)) {
+        std::cerr << "parse_into should skip unknown members up to the max depth" << std::endl;
+        return false;
+    }
+
+    // a failed parse must not leave anything behind for the next one
+    auto after_failure = json::parse(R"([[1, 2], [3)") ? std::nullopt : json::parse(R"([[4], {"k": [5]}])");
+    if (!after_failure || after_failure->to_string() != R"([[4],{"k":[5]}])") {
+        std::cerr << "Parsing after a failed parse is wrong" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
 bool jsonc_trail_comma()
 {
     std::string obj_trail = R"({ "key": 1, })";
@@ -150,3 +202,137 @@ bool jsonc_comment()
     }
     return true;
 }
+
+bool parse_into_struct()
+{
+    struct Item
+    {
+        std::string name;
+        double price = 0;
+
+        MEO_JSONIZATION(name, price);
+    };
+
+    struct Order
+    {
+        int id = 0;
+        bool paid = false;
+        std::vector<Item> items;
+        std::map<std::string, std::vector<int>> tags;
+        std::optional<std::string> note;
+        std::string customer;
+
+        MEO_JSONIZATION(id, MEO_OPT paid, items, tags, MEO_OPT note, MEO_KEY("customer_name") customer);
+    };
+
+    std::string text = R"({
+        "id": 42,
+        "unknown": {"nested": [1, "two", null, {"x": true}], "s": "\u00e9"},
+        "items": [{"name": "apple", "price": 1.5}, {"price": 2, "name": "pear\n", "extra": false}],
+        "tags": {"a": [1, 2], "b": []},
+        "note": null,
+        "customer_name": "Bob"
+    })";
+
+    Order order;
+    if (!json::parse_into(text, order) || order.id != 42 || order.paid || order.items.size() != 2 || order.items[1].name != "pear\n"
+        || order.items[1].price != 2 || order.tags.at("a") != std::vector<int> { 1, 2 } || order.note || order.customer != "Bob") {
+        std::cerr << "parse_into failed: " << text << std::endl;
+        return false;
+    }
+
+    // same result as going through json::value
+    json::value dom = *json::parse(text);
+    dom.as_object().erase("note");
+    Order from_value = dom.as<Order>();
+    if (json::value(from_value) != json::value(order)) {
+        std::cerr << "parse_into differs from as<T>: " << json::value(order) << std::endl;
+        return false;
+    }
+
+    std::string error_key;
+    if (json::parse_into(R"({"id": 1, "items": [{"name": "x", "price": "free"}], "tags": {}, "customer_name": ""})", order, error_key)
+        || error_key != "price") {
+        std::cerr << "parse_into wrong type, error_key: " << error_key << std::endl;
+        return false;
+    }
+    error_key.clear();
+    if (json::parse_into(R"({"id": 1, "items": [], "tags": {}})", order, error_key) || error_key != "customer_name") {
+        std::cerr << "parse_into missing key, error_key: " << error_key << std::endl;
+        return false;
+    }
+    if (json::parse_into(R"({"id": 1, "id": 2, "items": [], "tags": {}, "customer_name": ""})", order)
+        || json::parse_into(R"({"id": 1, "items": [], "tags": {}, "customer_name": ""} x)", order)
+        || json::parse_into(R"({"id": 1, "junk": [1,], "items": [], "tags": {}, "customer_name": ""})", order)) {
+        std::cerr << "parse_into accepted invalid json" << std::endl;
+        return false;
+    }
+
+    // the path to a failing member is only built when the conversion fails
+    json::value bad_price =
+        *json::parse(R"({"id": 1, "items": [{"name": "x", "price": 1}, {"name": "y", "price": "free"}], "tags": {}, "customer_name": ""})");
+    json::conversion_error conv_error;
+    if (bad_price.try_as<Order>(conv_error) || conv_error.path != "/items/1/price"
+        || conv_error.reason.find("free") == std::string::npos) {
+        std::cerr << "try_as error path: " << conv_error.path << ", " << conv_error.reason << std::endl;
+        return false;
+    }
+    json::value bad_tag = *json::parse(R"({"id": 1, "items": [], "tags": {"a/b": [1, true]}})");
+    if (bad_tag.try_as<Order>(conv_error) || conv_error.path != "/tags/a~1b/1") {
+        std::cerr << "try_as error path: " << conv_error.path << std::endl;
+        return false;
+    }
+    bad_tag["tags"] = json::object();
+    if (bad_tag.try_as<Order>(conv_error) || conv_error.path != "/customer_name" || conv_error.reason != "missing required field") {
+        std::cerr << "try_as missing field: " << conv_error.path << ", " << conv_error.reason << std::endl;
+        return false;
+    }
+    try {
+        bad_price.as<Order>();
+        std::cerr << "as<Order>() should throw" << std::endl;
+        return false;
+    }
+    catch (const json::exception& e) {
+        if (std::string(e.what()).find("/items/1/price") == std::string::npos) {
+            std::cerr << "as<Order>() message: " << e.what() << std::endl;
+            return false;
+        }
+    }
+    if (json::value(3).try_as<std::string>(conv_error) || !conv_error.path.empty() || conv_error.reason != json::value(3).value_info()) {
+        std::cerr << "try_as scalar error: " << conv_error.reason << std::endl;
+        return false;
+    }
+    // a failure nobody asked about must not show up in the next conversion of the same value
+    if (bad_price.try_as<Order>() || bad_price.try_as<int>(conv_error) || !conv_error.path.empty()
+        || conv_error.reason != bad_price.value_info()) {
+        std::cerr << "try_as reported a stale failure: " << conv_error.path << ", " << conv_error.reason << std::endl;
+        return false;
+    }
+    const json::value& first_item = bad_price.at("items").at(0);
+    if (first_item.try_as<Order>() || bad_price.at("items").try_as<std::vector<int>>(conv_error) || conv_error.path != "/0"
+        || conv_error.reason != first_item.value_info()) {
+        std::cerr << "try_as reported a stale child failure: " << conv_error.path << ", " << conv_error.reason << std::endl;
+        return false;
+    }
+
+    // names that share length and sampled characters land in the same slot of the key index
+    struct Similar
+    {
+        int axxa = 0;
+        int ayya = 0;
+        int azza = 0;
+        int bxxb = 0;
+        int other = 0;
+
+        MEO_JSONIZATION(axxa, ayya, azza, MEO_KEY("axxb") bxxb, MEO_OPT other);
+    };
+    Similar similar;
+    std::string similar_text = R"({"azza": 3, "axxb": 4, "ayya": 2, "axxa": 1, "axxc": 5})";
+    if (!json::parse_into(similar_text, similar) || similar.axxa != 1 || similar.ayya != 2 || similar.azza != 3 || similar.bxxb != 4
+        || json::parse(similar_text)->as<Similar>().bxxb != 4) {
+        std::cerr << "parse_into similar keys failed" << std::endl;
+        return false;
+    }
+
+    return true;
+}
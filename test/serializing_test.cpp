@@ -1,10 +1,12 @@
 #include <array>
+#include <clocale>
 #include <deque>
 #include <filesystem>
 #include <iostream>
 #include <list>
 #include <queue>
 #include <set>
+#include <sstream>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -149,6 +151,68 @@ bool serializing()
         return false;
     }
 
+    json::value fmt_val = json::object {
+        { "arr", json::array { 1, "two", json::array {} } },
+        { "empty", json::object {} },
+        { "nested", json::array { json::object { { "k", nullptr } } } },
+    };
+    std::string fmt_default = fmt_val.format(2);
+    if (fmt_default != "{\n  \"arr\": [\n    1,\n    \"two\",\n    [\n    ]\n  ],\n  \"empty\": {\n  },\n  \"nested\": [\n    {\n      \"k\": null\n    }\n  ]\n}") {
+        std::cerr << "error format: " << fmt_default << std::endl;
+        return false;
+    }
+    std::string fmt_tab_compact = fmt_val.format(json::format_options { 1, '\t', true });
+    if (fmt_tab_compact != "{\n\t\"arr\": [\n\t\t1,\n\t\t\"two\",\n\t\t[]\n\t],\n\t\"empty\": {\n\t},\n\t\"nested\": [\n\t\t{\n\t\t\t\"k\": null\n\t\t}\n\t]\n}") {
+        std::cerr << "error format with options: " << fmt_tab_compact << std::endl;
+        return false;
+    }
+
+    json::value blob_val = json::object {
+        { "blob", std::string(1000, 'x') },
+        { "escaped", std::string(100, 'y') + "\n" + std::string(10, 'z') },
+        { "list", json::array { 1, true, "short" } },
+    };
+    json::segment_buffer segments;
+    blob_val.dump_segments_to(segments);
+    bool blob_referenced = false;
+    for (const auto& seg : segments.segments()) {
+        blob_referenced |= seg.data() == blob_val.at("blob").as_string_view().data();
+    }
+    if (segments.to_string() != blob_val.to_string() || segments.size() != blob_val.to_string().size() || !blob_referenced
+        || segments.segments().size() != 5) {
+        std::cerr << "error segments: " << segments.to_string() << std::endl;
+        return false;
+    }
+
+    std::string appended = "prefix:";
+    blob_val.at("list").dump_to(appended);
+    json::serializer reused;
+    reused.dump(blob_val);
+    const size_t reused_capacity = reused.capacity();
+    std::string_view small_dump = reused.dump(blob_val.at("list"));
+    if (appended != "prefix:[1,true,\"short\"]" || small_dump != "[1,true,\"short\"]" || reused.capacity() < reused_capacity
+        || json::serializer::thread_local_instance().dump(blob_val) != blob_val.to_string()) {
+        std::cerr << "error dump_to: " << appended << ", " << small_dump << std::endl;
+        return false;
+    }
+
+    // long ASCII runs go through the SIMD block skip, invalid UTF-8 becomes U+FFFD
+    const std::string ascii_run(40, 'a');
+    json::value non_ascii_val = json::object {
+        { "caf\xC3\xA9", ascii_run + "\xE2\x82\xAC" + ascii_run + "\xF0\x9F\x98\x80\n" },
+        { "bad", "\xFF" + ascii_run },
+    };
+    std::string ascii_only = non_ascii_val.dumps(std::nullopt, true);
+    if (ascii_only != "{\"bad\":\"\\ufffd" + ascii_run + "\",\"caf\\u00e9\":\"" + ascii_run + "\\u20ac" + ascii_run + "\\ud83d\\ude00\\n\"}"
+        || non_ascii_val.dumps() != non_ascii_val.to_string() || non_ascii_val.to_string().find("\xE2\x82\xAC") == std::string::npos) {
+        std::cerr << "error ensure_ascii: " << ascii_only << std::endl;
+        return false;
+    }
+    if (non_ascii_val.dumps(0, true) != "{\n\"bad\": \"\\ufffd" + ascii_run + "\",\n\"caf\\u00e9\": \"" + ascii_run + "\\u20ac" + ascii_run + "\\ud83d\\ude00\\n\"\n}") {
+        std::cerr << "error ensure_ascii format: " << non_ascii_val.dumps(0, true) << std::endl;
+        return false;
+    }
+
     std::cout << root << std::endl;
     std::ofstream ofs("serializing.json");
     ofs << root;
@@ -230,6 +294,49 @@ bool jsonizing()
         return false;
     }
 
+    // written straight to text, fields in declaration order
+    struct Outer
+    {
+        std::vector<MyStruct> items;
+        std::optional<int> missing;
+        int renamed = 3;
+
+        MEO_TOJSON(items, MEO_OPT missing, MEO_KEY("new_name") renamed);
+    };
+    Outer outer;
+    outer.items = { mine, mine };
+    std::string direct = json::serialize(outer);
+    auto direct_parsed = json::parse(direct);
+    if (direct.rfind("],\"missing\":null,\"new_name\":3}") == std::string::npos || !direct_parsed
+        || *direct_parsed != json::value(outer)) {
+        std::cerr << "error serialize: " << direct << std::endl;
+        return false;
+    }
+
+    // vectors of records share the escaped keys and can be streamed in chunks
+    struct Record
+    {
+        int id = 0;
+        std::string name;
+
+        MEO_TOJSON(id, MEO_KEY("the \"name\"") name);
+    };
+    std::vector<Record> records(100);
+    for (size_t i = 0; i < records.size(); ++i) {
+        records[i].id = static_cast<int>(i);
+        records[i].name = "record " + std::to_string(i);
+    }
+    std::string records_text = json::serialize(records);
+    std::ostringstream records_stream;
+    json::serialize_to(records_stream, records, 64);
+    auto records_parsed = json::parse(records_text);
+    if (records_text.rfind("{\"id\":99,\"the \\\"name\\\"\":\"record 99\"}]") == std::string::npos || !records_parsed
+        || *records_parsed != json::value(records) || records_stream.str() != records_text
+        || json::serialize(std::vector<Record> {}) != "[]") {
+        std::cerr << "error serialize records: " << records_text.substr(0, 100) << std::endl;
+        return false;
+    }
+
     struct OptTest
     {
         int a = 0;
@@ -345,5 +452,97 @@ bool jsonizing()
         return false;
     }
 
+    // MEO_FROMJSON from an rvalue moves string and container payloads out of the DOM
+    struct Blob
+    {
+        std::string data;
+        std::vector<std::string> chunks;
+
+        MEO_JSONIZATION(data, chunks);
+    };
+    json::value blob_j = json::object { { "data", std::string(256, 'x') },
+                                        { "chunks", json::array { std::string(128, 'y') } } };
+    const char* data_ptr = blob_j["data"].as_string_view().data();
+    const char* chunk_ptr = blob_j["chunks"][0].as_string_view().data();
+    Blob blob = std::move(blob_j).as<Blob>();
+    if (blob.data.data() != data_ptr || blob.chunks.size() != 1 || blob.chunks[0].data() != chunk_ptr) {
+        std::cerr << "MEO_FROMJSON rvalue not moved" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool canonicalizing()
+{
+    // sample from RFC 8785, section 3.2.2
+    auto rfc_sample = json::parse(
+        R"({"numbers": [333333333.33333329, 1E30, 4.50, 2e-3, 0.000000000000000000000000001],)"
+        R"("string": "\u20ac$\u000F\u000aA'\u0042\u0022\u005c\\\"\/", "literals": [null, true, false]})");
+    const std::string rfc_expected = "{\"literals\":[null,true,false],\"numbers\":[333333333.3333333,1e+30,4.5,0.002,1e-27],"
+                                     "\"string\":\"\xE2\x82\xAC$\\u000f\\nA'B\\\"\\\\\\\\\\\"/\"}";
+    if (!rfc_sample || rfc_sample->dumps_canonical() != rfc_expected) {
+        std::cerr << "error canonical: " << (rfc_sample ? rfc_sample->dumps_canonical() : "parse failed") << std::endl;
+        return false;
+    }
+
+    // keys are sorted by UTF-16 code units, RFC 8785, section 3.2.3
+    auto sort_sample = json::parse(
+        R"({"\u20ac": "Euro Sign", "\r": "Carriage Return", "\ufb33": "Hebrew Letter Dalet With Dagesh", "1": "One",)"
+        R"("\ud83d\ude00": "Emoji: Grinning Face", "\u0080": "Control", "\u00f6": "Latin Small Letter O With Diaeresis"})");
+    const std::string sorted_expected = "{\"\\r\":\"Carriage Return\",\"1\":\"One\",\"\xC2\x80\":\"Control\","
+                                        "\"\xC3\xB6\":\"Latin Small Letter O With Diaeresis\",\"\xE2\x82\xAC\":\"Euro Sign\","
+                                        "\"\xF0\x9F\x98\x80\":\"Emoji: Grinning Face\",\"\xEF\xAC\xB3\":\"Hebrew Letter Dalet With Dagesh\"}";
+    if (!sort_sample || sort_sample->dumps_canonical() != sorted_expected) {
+        std::cerr << "error canonical key order: " << (sort_sample ? sort_sample->dumps_canonical() : "parse failed") << std::endl;
+        return false;
+    }
+
+    json::value numbers = json::array { 0, -0.0, 1e21, 1e20, 1e-7, 0.000001, 5e-324, -1.5, 123456789012345678.0, 100 };
+    if (numbers.dumps_canonical() != "[0,0,1e+21,100000000000000000000,1e-7,0.000001,5e-324,-1.5,123456789012345680,100]") {
+        std::cerr << "error canonical numbers: " << numbers.dumps_canonical() << std::endl;
+        return false;
+    }
+
+    // an underflow rounds to 0 as in ECMAScript, an overflow is not a finite number
+    auto tiny = json::parse("[1e-400, -0.0000000000000000000000000000000000000001e-300, 4.9e-324, 0.000001e+2]");
+    if (!tiny || tiny->dumps_canonical() != "[0,0,5e-324,0.0001]") {
+        std::cerr << "error canonical underflow: " << (tiny ? tiny->dumps_canonical() : "parse failed") << std::endl;
+        return false;
+    }
+    bool overflow_thrown = false;
+    try {
+        json::parse("[1e400]")->dumps_canonical();
+    }
+    catch (const json::exception&) {
+        overflow_thrown = true;
+    }
+    if (!overflow_thrown) {
+        std::cerr << "error canonical overflow should throw" << std::endl;
+        return false;
+    }
+
+    // numbers are read the same under a locale with a decimal comma, when one is installed
+    const std::string saved_locale = std::setlocale(LC_NUMERIC, nullptr);
+    if (std::setlocale(LC_NUMERIC, "de_DE.UTF-8") || std::setlocale(LC_NUMERIC, "fr_FR.UTF-8")) {
+        const std::string localized = rfc_sample->dumps_canonical();
+        std::setlocale(LC_NUMERIC, saved_locale.c_str());
+        if (localized != rfc_expected) {
+            std::cerr << "error canonical under decimal comma locale: " << localized << std::endl;
+            return false;
+        }
+    }
+
+    std::string streamed;
+    size_t chunks = 0;
+    rfc_sample->dump_canonical_to([&](std::string_view chunk) {
+        streamed.append(chunk);
+        ++chunks;
+    });
+    if (streamed != rfc_expected || chunks != 1) {
+        std::cerr << "error canonical sink: " << streamed << std::endl;
+        return false;
+    }
+
     return true;
 }
@@ -2,3 +2,4 @@
 
 extern bool serializing();
 extern bool jsonizing();
+extern bool canonicalizing();
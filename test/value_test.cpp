@@ -1,10 +1,52 @@
+#include <clocale>
 #include <iostream>
 #include <limits>
 #include <string>
+#include <unordered_set>
 
 #include "json.hpp"
 #include "value_test.h"
 
+// Same fields, so only the tag tells the alternatives apart
+struct Circle
+{
+    double size = 0;
+
+    MEO_JSONIZATION(size);
+};
+
+struct Square
+{
+    double size = 0;
+
+    MEO_JSONIZATION(size);
+};
+
+using Shape = std::variant<Circle, Square>;
+using ShapeByIndex = std::variant<Square, Circle>;
+
+template <>
+class json::ext::variant_tag<Shape>
+{
+public:
+    static constexpr std::string_view key = "type";
+    static constexpr std::string_view tags[] = { "circle", "square" };
+};
+
+template <>
+class json::ext::variant_tag<ShapeByIndex>
+{
+public:
+    size_t index(const json::value& in) const
+    {
+        if (in.is_object() && in.contains("kind") && !in.at("kind").is_number()) {
+            throw json::exception("kind must be a number");
+        }
+        auto kind = in.find<int>("kind");
+        return kind && *kind >= 0 && *kind < 2 ? static_cast<size_t>(*kind) : std::variant_npos;
+    }
+};
+
 bool test_value_constructors();
 bool test_value_type_checks();
 bool test_value_access_methods();
@@ -12,6 +54,13 @@ bool test_value_conversion_methods();
 bool test_value_operators();
 bool test_value_modification();
 bool test_value_extended_conversions();
+bool test_value_persistent();
+bool test_value_deep_nesting();
+bool test_value_hash();
+bool test_value_merge();
+bool test_value_memory_usage();
+bool test_value_compact();
+bool test_value_frozen();
 
 static std::string increment_decimal_string(std::string value)
 {
@@ -35,7 +84,9 @@ bool value_test()
 {
     return test_value_constructors() && test_value_type_checks() && test_value_access_methods()
            && test_value_conversion_methods() && test_value_operators() && test_value_modification()
-           && test_value_extended_conversions();
+           && test_value_extended_conversions() && test_value_persistent() && test_value_deep_nesting()
+           && test_value_hash() && test_value_merge() && test_value_memory_usage()
+           && test_value_compact() && test_value_frozen();
 }
 
 bool test_value_constructors()
@@ -621,6 +672,17 @@ bool test_value_conversion_methods()
         return false;
     }
 
+    // try_as<T>测试
+    json::value v_mixed = json::array { 1, json::array { 2, 3 }, "x" };
+    auto as_tuple = v_mixed.try_as<std::tuple<int, std::vector<int>, std::string>>();
+    auto null_opt = json::value(nullptr).try_as<std::optional<int>>();
+    if (!as_tuple || !null_opt || null_opt->has_value() || std::get<1>(*as_tuple).size() != 2 || std::get<2>(*as_tuple) != "x"
+        || v_mixed.try_as<std::vector<int>>() || v_vec.try_as<std::vector<int>>() != vec || json::value(1.5).try_as<int>()
+        || v_map.try_as<std::map<std::string, std::variant<std::string, int>>>()->at("b") != std::variant<std::string, int>(2)) {
+        std::cerr << "try_as<T>() test failed" << std::endl;
+        return false;
+    }
+
     std::cout << "Value conversion methods test passed" << std::endl;
     return true;
 }
@@ -812,6 +874,27 @@ bool test_value_modification()
         return false;
     }
 
+    // snapshots share nodes until one side modifies them
+    json::value doc = json::object { { "config", json::object { { "depth", 1 } } }, { "list", json::array { 1, 2, 3 } } };
+    json::value snap = doc.snapshot();
+    const json::value& const_doc = doc;
+    const json::value& const_snap = snap;
+    if (&const_doc.as_object() != &const_snap.as_object() || snap != doc) {
+        std::cerr << "snapshot() should share the document" << std::endl;
+        return false;
+    }
+    snap["config"]["depth"] = 2;
+    if (doc["config"]["depth"].as_integer() != 1 || const_snap.at("config").at("depth").as_integer() != 2
+        || &const_doc.at("list").as_array() != &const_snap.at("list").as_array()) {
+        std::cerr << "snapshot() modification leaked or unmodified siblings were cloned" << std::endl;
+        return false;
+    }
+    doc["list"].emplace(4);
+    if (const_snap.at("list").as_array().size() != 3 || doc["list"].as_array().size() != 4) {
+        std::cerr << "snapshot() modification of the original leaked" << std::endl;
+        return false;
+    }
+
     std::cout << "Value modification test passed" << std::endl;
     return true;
 }
@@ -1020,6 +1103,546 @@ bool test_value_extended_conversions()
         return false;
     }
 
+    // tagged variants convert only the alternative named by the tag
+    json::value square_j = json::object { { "type", "square" }, { "size", 2 } };
+    if (!square_j.is<Shape>() || !std::holds_alternative<Square>(square_j.as<Shape>())
+        || std::get<Square>(square_j.as<Shape>()).size != 2 || !square_j.try_as<Shape>()
+        || square_j.try_as<Shape>()->index() != 1 || std::move(square_j).as<Shape>().index() != 1) {
+        std::cerr << "tagged variant by key failed" << std::endl;
+        return false;
+    }
+
+    json::value unknown_j = json::object { { "type", "triangle" }, { "size", 2 } };
+    bool unknown_threw = false;
+    try {
+        unknown_j.as<Shape>();
+    }
+    catch (const json::exception&) {
+        unknown_threw = true;
+    }
+    if (unknown_j.is<Shape>() || unknown_j.try_as<Shape>() || !unknown_threw) {
+        std::cerr << "tagged variant with unknown tag should not convert" << std::endl;
+        return false;
+    }
+
+    json::value circle_j = json::object { { "kind", 1 }, { "size", 3 } };
+    auto by_index = circle_j.as<ShapeByIndex>();
+    if (!std::holds_alternative<Circle>(by_index) || std::get<Circle>(by_index).size != 3
+        || json::value(json::object { { "kind", 5 } }).is<ShapeByIndex>()
+        || json::value(json::object { { "kind", "circle" } }).is<ShapeByIndex>()) {
+        std::cerr << "tagged variant by index failed" << std::endl;
+        return false;
+    }
+
     std::cout << "Value extended conversions test passed" << std::endl;
     return true;
 }
+
+bool test_value_persistent()
+{
+    std::cout << "Testing persistent value..." << std::endl;
+
+    json::persistent_value v1(json::object {
+        { "servers", json::array { json::object { { "port", 80 } }, json::object { { "port", 81 } } } },
+        { "limits", json::object { { "a/b", 1 } } },
+    });
+    json::persistent_value v2 = v1.set("/servers/1/port", 8081);
+    json::persistent_value v3 = v2.set("/servers/-", json::object { { "port", 90 } }).set("/new/key", true).erase("/limits/a~1b");
+
+    if (v1.at("servers").at(1).at("port").as_integer() != 81 || v2.at("servers").at(1).at("port").as_integer() != 8081
+        || v3.at("servers").size() != 3 || !v3.find("/new/key") || v3.find("/limits/a~1b") || !v2.find("/limits/a~1b")
+        || v1.find("/servers/2") || v1.find("/servers/01")) {
+        std::cerr << "persistent_value versions are wrong: " << v3 << std::endl;
+        return false;
+    }
+
+    // untouched subtrees are shared between versions
+    if (!v1.at("limits").shares(v2.at("limits")) || !v1.at("servers").at(0).shares(v2.at("servers").at(0))
+        || v1.at("servers").at(1).shares(v2.at("servers").at(1))) {
+        std::cerr << "persistent_value should share untouched nodes" << std::endl;
+        return false;
+    }
+
+    json::value plain = v2.to_value();
+    plain["servers"][0]["port"] = 1;
+    if (v2.at("servers").at(0).at("port").as_integer() != 80 || json::persistent_value(v2.to_value()) != v2) {
+        std::cerr << "persistent_value::to_value() should be independent" << std::endl;
+        return false;
+    }
+
+    bool threw = false;
+    try {
+        v1.set("/servers/5/port", 1);
+    }
+    catch (const json::exception&) {
+        threw = true;
+    }
+    if (!threw) {
+        std::cerr << "persistent_value::set() out of range should throw" << std::endl;
+        return false;
+    }
+
+    // wide containers: a version copies a few chunks, not every member or element
+    json::value wide;
+    for (int i = 0; i < 5000; ++i) {
+        wide["key " + std::to_string(i)] = json::object { { "id", i } };
+        wide["list"].as_array().emplace_back(i);
+    }
+    const json::persistent_value wide_v1(wide);
+    const json::persistent_value wide_v2 = wide_v1.set("/key 2500/id", -1).set("/list/4000", -1);
+    wide["key 2500"]["id"] = -1;
+    wide["list"][4000] = -1;
+    if (wide_v2.to_value() != wide || wide_v1.at("key 2500").at("id").as_integer() != 2500
+        || !wide_v1.at("key 10").shares(wide_v2.at("key 10")) || wide_v2.at("list").at(4000).as_integer() != -1
+        || wide_v1.at("list").at(4000).as_integer() != 4000) {
+        std::cerr << "persistent_value wide versions are wrong" << std::endl;
+        return false;
+    }
+
+    // chunk splits and merges against json::array and json::object doing the same edits
+    json::value model = json::object { { "list", json::array {} } };
+    json::persistent_value history(model);
+    std::vector<json::persistent_value> versions;
+    unsigned seed = 12345;
+    auto next = [&seed](unsigned bound) {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 8) % bound;
+    };
+    for (int step = 0; step < 6000; ++step) {
+        const size_t size = model.as_object().size();
+        const std::string key = std::to_string(next(2000));
+        json::array& list = model["list"].as_array();
+        const unsigned op = next(4);
+        if (op == 0 && !list.empty()) {
+            const size_t index = next(static_cast<unsigned>(list.size()));
+            list.erase(index);
+            history = history.erase("/list/" + std::to_string(index));
+        }
+        else if (op == 1) {
+            list.emplace_back(step);
+            history = history.set("/list/-", step);
+        }
+        else if (op == 2 && size > 1) {
+            model.as_object().erase(key);
+            history = history.erase("/" + key);
+        }
+        else {
+            model[key] = step;
+            history = history.set("/" + key, step);
+        }
+        if (step % 500 == 0) {
+            versions.emplace_back(history);
+        }
+    }
+    if (history.to_value() != model || json::persistent_value(model) != history || versions.front() == history
+        || versions.back().to_value().as_object().size() == 0) {
+        std::cerr << "persistent_value edits do not match json::value" << std::endl;
+        return false;
+    }
+
+    std::cout << "Persistent value test passed" << std::endl;
+    return true;
+}
+
+bool test_value_deep_nesting()
+{
+    std::cout << "Testing deep nesting..." << std::endl;
+
+    // far deeper than a recursive copy, comparison, dump, format or destructor could handle
+    constexpr size_t depth = 100000;
+    auto make_deep = [](int leaf) {
+        json::value deep = leaf;
+        for (size_t i = 0; i < depth; ++i) {
+            if (i % 2 == 0) {
+                json::array level;
+                level.emplace_back(std::move(deep));
+                deep = std::move(level);
+            }
+            else {
+                json::object level;
+                level.emplace("k", std::move(deep));
+                deep = std::move(level);
+            }
+        }
+        return deep;
+    };
+
+    json::value deep = make_deep(1);
+    json::value copied = deep;
+    if (copied != deep || deep == make_deep(2)) {
+        std::cerr << "deep comparison is wrong" << std::endl;
+        return false;
+    }
+
+    std::string dumped = copied.to_string();
+    if (dumped.size() != depth / 2 * 8 + 1 || dumped.compare(0, 7, "{\"k\":[{") != 0) {
+        std::cerr << "deep dump is wrong: " << dumped.substr(0, 32) << std::endl;
+        return false;
+    }
+
+    // "[\n" "\n]" around each array, "{\n\"k\": " "\n}" around each object
+    const std::string formatted = copied.format(0);
+    if (formatted.size() != depth / 2 * 13 + 1 || formatted.compare(0, 10, "{\n\"k\": [\n{") != 0
+        || copied.dumps_canonical() != dumped) {
+        std::cerr << "deep format is wrong: " << formatted.substr(0, 32) << std::endl;
+        return false;
+    }
+
+    copied = json::value();
+    deep.as_object().clear();
+
+    std::cout << "Deep nesting test passed" << std::endl;
+    return true;
+}
+
+bool test_value_hash()
+{
+    std::cout << "Testing value hash..." << std::endl;
+
+    json::value doc = json::object {
+        { "name", "meojson" },
+        { "tags", json::array { 1, "1", true, json::value() } },
+        { "nested", json::object { { "a", json::object { { "b", 1 } } } } },
+    };
+    json::value same = doc;
+    const size_t doc_hash = doc.hash();
+    if (doc_hash != std::hash<json::value> {}(same) || json::value(1).hash() == json::value("1").hash()) {
+        std::cerr << "Equal values should hash equally and different types differently" << std::endl;
+        return false;
+    }
+
+    // modifying a nested member goes through the non-const accessors of every ancestor
+    same["nested"]["a"]["b"] = 2;
+    if (same.hash() == doc_hash || same == doc) {
+        std::cerr << "Hash cache should be invalidated by modification" << std::endl;
+        return false;
+    }
+    same["nested"]["a"]["b"] = 1;
+    if (same.hash() != doc_hash || same != doc) {
+        std::cerr << "Hash should follow the content" << std::endl;
+        return false;
+    }
+
+    json::value snap = doc.snapshot();
+    snap["tags"].as_array().emplace_back(2);
+    if (doc.hash() != doc_hash || snap.hash() == doc_hash) {
+        std::cerr << "Snapshots should not share stale hashes" << std::endl;
+        return false;
+    }
+
+    // nodes copied or moved out of a hashed value are modified without going through json::value
+    const json::value cached = json::object { { "a", 1 }, { "list", json::array { 1 } } };
+    cached.hash();
+    json::object copied_obj = cached.as_object();
+    copied_obj["b"] = 2;
+    json::array copied_arr = cached.at("list").as_array();
+    copied_arr.emplace_back(2);
+    const json::value wrapped_obj = std::move(copied_obj);
+    const json::value wrapped_arr = std::move(copied_arr);
+    const json::value same_obj = json::object { { "a", 1 }, { "b", 2 }, { "list", json::array { 1 } } };
+    const json::value same_arr = json::array { 1, 2 };
+    same_obj.hash();
+    same_arr.hash();
+    if (wrapped_obj != same_obj || wrapped_obj.hash() != same_obj.hash() || wrapped_arr != same_arr
+        || wrapped_arr.hash() != same_arr.hash()) {
+        std::cerr << "Copied nodes should not keep a stale hash" << std::endl;
+        return false;
+    }
+
+    // a reference held into a child skips the caches of its parents, equality must not trust them
+    json::value held = json::object { { "a", json::object { { "b", 1 } } } };
+    const json::value held_expected = json::object { { "a", json::object { { "b", 2 } } } };
+    json::value& child = held["a"];
+    held.hash();
+    held_expected.hash();
+    child["b"] = 2;
+    json::value big = json::array { json::array { 1 }, 2 };
+    const json::value big_expected = json::array { json::array { 1, 9 }, 2 };
+    big.hash();
+    big_expected.hash();
+    big[0].as_array().emplace_back(9);
+    if (held.dumps() != held_expected.dumps() || held != held_expected || big != big_expected) {
+        std::cerr << "operator== should not depend on stale hash caches" << std::endl;
+        return false;
+    }
+
+    std::unordered_set<json::value> seen { doc, same, snap, json::array { 1, 2 } };
+    if (seen.size() != 3 || !seen.count(json::array { 1, 2 }) || seen.count(json::array { 2, 1 })) {
+        std::cerr << "unordered_set<json::value> is wrong" << std::endl;
+        return false;
+    }
+
+    std::cout << "Value hash test passed" << std::endl;
+    return true;
+}
+
+bool test_value_merge()
+{
+    std::cout << "Testing value merge..." << std::endl;
+
+    const json::value defaults = json::object {
+        { "server", json::object { { "host", "localhost" }, { "port", 80 }, { "tags", json::array { "a" } } } },
+        { "debug", false },
+    };
+    auto make_env = []() {
+        return json::value(json::object {
+            { "server", json::object { { "port", 8080 }, { "tags", json::array { "b" } } } },
+            { "cache", json::object { { "size", 64 } } },
+        });
+    };
+    const json::value expected = json::object {
+        { "server", json::object { { "host", "localhost" }, { "port", 8080 }, { "tags", json::array { "b" } } } },
+        { "debug", false },
+        { "cache", json::object { { "size", 64 } } },
+    };
+
+    json::value copied = defaults;
+    const json::value env = make_env();
+    copied.merge(env);
+    if (copied != expected || env != make_env()) {
+        std::cerr << "merge(const value&) is wrong: " << copied << std::endl;
+        return false;
+    }
+
+    // members missing in the destination are spliced over, so their nodes do not move
+    json::value moved_env = make_env();
+    const json::object* cache_node = &moved_env.at("cache").as_object();
+    json::value moved = defaults;
+    moved.merge(std::move(moved_env));
+    if (moved != expected || &moved.at("cache").as_object() != cache_node) {
+        std::cerr << "merge(value&&) is wrong: " << moved << std::endl;
+        return false;
+    }
+
+    json::value concat = defaults;
+    concat.merge(make_env(), json::array_merge::concat);
+    if (concat.at("server").at("tags") != json::array { "a", "b" }) {
+        std::cerr << "array_merge::concat is wrong: " << concat << std::endl;
+        return false;
+    }
+
+    json::value by_index = json::array { json::object { { "a", 1 } }, json::object { { "b", 2 } } };
+    by_index.merge(json::array { json::object { { "c", 3 } }, 4, 5 }, json::array_merge::by_index);
+    if (by_index != json::array { json::object { { "a", 1 }, { "c", 3 } }, 4, 5 }) {
+        std::cerr << "array_merge::by_index is wrong: " << by_index << std::endl;
+        return false;
+    }
+
+    // rhs aliasing the destination
+    json::value self = json::object { { "list", json::array { 1, 2 } }, { "obj", json::object { { "list", json::array { 3 } } } } };
+    self.merge(self, json::array_merge::concat);
+    if (self != json::object { { "list", json::array { 1, 2, 1, 2 } }, { "obj", json::object { { "list", json::array { 3, 3 } } } } }) {
+        std::cerr << "merge with itself is wrong: " << self << std::endl;
+        return false;
+    }
+    self.merge(self.at("obj"), json::array_merge::concat);
+    if (self.at("list") != json::array { 1, 2, 1, 2, 3, 3 } || self.at("obj").at("list") != json::array { 3, 3 }) {
+        std::cerr << "merge with a part of itself is wrong: " << self << std::endl;
+        return false;
+    }
+    const json::value before_self_move = self;
+    self.merge(std::move(self));
+    if (self != before_self_move) {
+        std::cerr << "merge(std::move(self)) is wrong: " << self << std::endl;
+        return false;
+    }
+
+    json::object lhs { { "a", 1 }, { "b", 2 } };
+    json::object rhs { { "b", 3 }, { "c", 4 } };
+    if ((lhs | json::object(rhs)) != json::object { { "a", 1 }, { "b", 3 }, { "c", 4 } }
+        || (json::object(lhs) |= std::move(rhs)) != json::object { { "a", 1 }, { "b", 3 }, { "c", 4 } }) {
+        std::cerr << "object operator| is wrong" << std::endl;
+        return false;
+    }
+
+    std::cout << "Value merge test passed" << std::endl;
+    return true;
+}
+
+bool test_value_memory_usage()
+{
+    std::cout << "Testing value memory usage..." << std::endl;
+
+    if (json::value(42).memory_usage().total() != 0 || json::value("short").memory_usage().total() != 0) {
+        std::cerr << "scalars without heap strings should report no memory" << std::endl;
+        return false;
+    }
+
+    const std::string long_text(1000, 'x');
+    json::value doc = json::object { { "list", json::array { long_text, 1, true, nullptr } },
+                                     { "obj", json::object { { "k", "v" } } } };
+
+    auto stats = doc.memory_usage();
+    if (stats.objects != 2 || stats.arrays != 1 || stats.string_values != 2 || stats.numbers != 1
+        || stats.booleans != 1 || stats.nulls != 1) {
+        std::cerr << "memory_usage type counts are wrong" << std::endl;
+        return false;
+    }
+    if (stats.strings < long_text.size() || stats.object_nodes == 0 || stats.containers == 0
+        || stats.array_slack > stats.array_buffers || stats.total() <= long_text.size()) {
+        std::cerr << "memory_usage sizes are wrong" << std::endl;
+        return false;
+    }
+
+    // nodes shared by snapshots are counted once
+    json::value shared = json::array {};
+    shared.as_array().emplace_back(doc.snapshot());
+    shared.as_array().emplace_back(doc.snapshot());
+    auto shared_stats = shared.memory_usage();
+    if (shared_stats.objects != stats.objects || shared_stats.strings != stats.strings) {
+        std::cerr << "memory_usage should count shared nodes once" << std::endl;
+        return false;
+    }
+
+    // children shared with a snapshot after the root was detached from it
+    json::value wide = json::array {};
+    for (int i = 0; i < 20000; ++i) {
+        wide.as_array().emplace_back(json::object { { "i", i } });
+    }
+    const auto wide_stats = wide.memory_usage();
+    const json::value wide_snap = wide.snapshot();
+    wide.as_array().emplace_back(1);
+    const auto detached_stats = wide.memory_usage();
+    if (detached_stats.objects != wide_stats.objects || detached_stats.object_nodes != wide_stats.object_nodes
+        || detached_stats.numbers != wide_stats.numbers + 1) {
+        std::cerr << "memory_usage is wrong for many shared children" << std::endl;
+        return false;
+    }
+
+    std::cout << "Value memory usage test passed" << std::endl;
+    return true;
+}
+
+bool test_value_compact()
+{
+    std::cout << "Testing value compact..." << std::endl;
+
+    // strings built up in place keep their spare capacity when moved into the tree
+    auto loose_string = [](char ch) {
+        std::string str(100, ch);
+        str.reserve(1000);
+        return str;
+    };
+    json::value doc;
+    json::value list = json::array {};
+    for (int i = 0; i < 100; ++i) {
+        list.as_array().emplace_back(loose_string('t'));
+    }
+    doc[loose_string('k')] = std::move(list);
+    doc["tight"] = json::array { 1, 2, 3 };
+    const json::value expected = doc;
+
+    const auto before = doc.memory_usage();
+    const size_t reclaimed = doc.compact();
+    const auto after = doc.memory_usage();
+    if (doc != expected || reclaimed == 0 || before.total() - after.total() != reclaimed || after.array_slack != 0) {
+        std::cerr << "compact is wrong, reclaimed " << reclaimed << std::endl;
+        return false;
+    }
+    if (doc.compact() != 0) {
+        std::cerr << "compact of a compacted value should reclaim nothing" << std::endl;
+        return false;
+    }
+
+    // a node shared with a snapshot is left as it is
+    json::value shared = json::array {};
+    for (int i = 0; i < 5; ++i) {
+        shared.as_array().emplace_back(loose_string('s'));
+    }
+    const json::value snap = shared.snapshot();
+    if (shared.compact() != 0 || snap != shared) {
+        std::cerr << "compact should skip shared nodes" << std::endl;
+        return false;
+    }
+
+    std::cout << "Value compact test passed" << std::endl;
+    return true;
+}
+
+bool test_value_frozen()
+{
+    std::cout << "Testing frozen value..." << std::endl;
+
+    const json::value doc = json::object {
+        { "name", "meojson" },
+        { "ratio", 0.25 },
+        { "sizes", json::array { 1, -2, 300000000000LL, nullptr, true, false } },
+        { "nested", json::object { { "z", json::array {} }, { "a", json::object {} }, { "", "empty key" } } },
+    };
+
+    const json::frozen_value frozen(doc);
+    const auto root = frozen.root();
+    if (!root.is_object() || root.size() != 4 || root.at("name").as_string() != "meojson"
+        || root.at("ratio").as_double() != 0.25 || root.at("sizes").at(2).as_long_long() != 300000000000LL
+        || !root.at("sizes").at(3).is_null() || !root.at("sizes").at(4).as_boolean()
+        || root.at("nested").at("").as_string() != "empty key" || root.at("nested").key_at(0) != "") {
+        std::cerr << "frozen_value lookups are wrong" << std::endl;
+        return false;
+    }
+    // numbers are read the same under a locale with a decimal comma, when one is installed
+    const std::string saved_locale = std::setlocale(LC_NUMERIC, nullptr);
+    if (std::setlocale(LC_NUMERIC, "de_DE.UTF-8") || std::setlocale(LC_NUMERIC, "fr_FR.UTF-8")) {
+        const double localized = root.at("ratio").as_double();
+        std::setlocale(LC_NUMERIC, saved_locale.c_str());
+        if (localized != 0.25) {
+            std::cerr << "frozen_value as_double under decimal comma locale: " << localized << std::endl;
+            return false;
+        }
+    }
+    if (root.find("missing") || root.at("sizes").find(6) || root.contains("sizes") == false) {
+        std::cerr << "frozen_value find is wrong" << std::endl;
+        return false;
+    }
+    bool thrown = false;
+    try {
+        root.at("name").as_integer();
+    }
+    catch (const json::exception&) {
+        thrown = true;
+    }
+    if (!thrown || frozen.to_value() != doc || json::frozen_value().root().is_null() == false) {
+        std::cerr << "frozen_value conversions are wrong" << std::endl;
+        return false;
+    }
+
+    // parsed straight from text; members are sorted whatever order they were written in
+    const std::string text = R"({ "b": [1, 2.5e3, "x\n"], "a": { "c": null, "b": true } })";
+    auto parsed = json::parse_frozen(text);
+    if (!parsed || parsed->to_value() != *json::parse(text) || parsed->root().key_at(0) != "a"
+        || parsed->root().at("b").at(1).as_number_text() != "2.5e3") {
+        std::cerr << "parse_frozen is wrong" << std::endl;
+        return false;
+    }
+    if (json::parse_frozen(R"({ "a": 1, "a": 2 })") || json::parse_frozen("[1, 2") || json::parse_frozen("[x]")
+        || json::parse_frozen("1") || json::parse_frozen("[[1]]", 1) || !json::parse_frozen("[[1]]", 2)) {
+        std::cerr << "parse_frozen should reject what parse rejects" << std::endl;
+        return false;
+    }
+
+    // an underflow reads as 0, an overflow throws
+    const json::frozen_value ranges(json::parse("[1e-400, 1e400]").value_or(json::value()));
+    bool overflow_thrown = false;
+    try {
+        ranges.root().at(1).as_double();
+    }
+    catch (const json::exception&) {
+        overflow_thrown = true;
+    }
+    if (ranges.root().at(0).as_double() != 0 || !overflow_thrown) {
+        std::cerr << "frozen_value as_double out of range is wrong" << std::endl;
+        return false;
+    }
+
+    // the buffer is self-contained and can be copied anywhere
+    const std::string copied(parsed->bytes());
+    auto loaded = json::frozen_value::from_bytes(copied);
+    auto viewed = json::frozen_value::view(copied);
+    if (!loaded || !viewed || loaded->to_value() != parsed->to_value() || viewed->at("a").at("b").as_boolean() != true
+        || json::frozen_value::from_bytes(copied.substr(1))) {
+        std::cerr << "frozen_value bytes are wrong" << std::endl;
+        return false;
+    }
+
+    std::cout << "Frozen value test passed" << std::endl;
+    return true;
+}